@@ -0,0 +1,39 @@
+#ifndef ASSEMBLER_H
+#define ASSEMBLER_H
+
+#include "computron.h"
+
+// The mnemonic the assembler accepts for a command: READ, WRITE, LOAD,
+// STORE, ADD, SUB, DIV, MUL, BR, BRNEG, BRZ or HALT
+const char* mnemonic(Command command);
+
+// Assembles SML source straight into memory and returns the number of cells
+// used, like load_from_file(). One statement per line:
+//
+//   [label:] MNEMONIC operand   ; operand is a cell number or a label
+//   [label:] HALT               ; the operand is optional, 00 by default
+//   [label:] DATA word          ; a literal word, or the address of a label
+//
+// Mnemonics are case-insensitive, labels are not, and ';' starts a comment.
+// Labels may be used before they are defined. Errors throw runtime_error
+// naming the offending line.
+size_t assemble(std::string_view source, std::array<int, memorySize>& memory);
+
+// Writes the first 'count' words in the text format load_from_file() reads,
+// one per line and terminated by the -99999 sentinel
+void write_program(const std::array<int, memorySize>& memory, size_t count, std::ostream& out);
+
+// Assembles 'sourceFile' into a text program for load_from_file()
+void assemble_file(const std::string& sourceFile, const std::string& programFile);
+
+// Writes the image as source assemble() accepts. Cells reachable from
+// 'entry' are listed as instructions and branch targets get labels; every
+// other cell, and any reachable word that is not a valid instruction, is
+// listed as DATA. Trailing zero data cells are left out unless a branch
+// targets them, so the listing reassembles to the same image. Each line's comment
+// gives its address and word, plus its execution count, time and share of
+// the total time when a profile is given.
+void disassemble(const std::array<int, memorySize>& memory, std::ostream& out,
+	size_t entry = 0, const Profile* profile = nullptr);
+
+#endif // ASSEMBLER_H
@@ -0,0 +1,16 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "computron.h"
+
+using BatchResult = RunResult;
+
+// Runs 'image' once per input vector. Lanes are kept in structure-of-arrays
+// form and every step executes all lanes that sit at the same instruction
+// counter with the same instruction word together, in SSE2 kernels (AVX2
+// where the build targets it, plain loops elsewhere) over 32-bit lanes. A
+// lane that faults stops with its error recorded instead of aborting the batch.
+std::vector<BatchResult> execute_batch(const std::array<int, memorySize>& image,
+	const std::vector<std::vector<int>>& inputs);
+
+#endif // BATCH_H
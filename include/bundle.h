@@ -0,0 +1,78 @@
+#ifndef BUNDLE_H
+#define BUNDLE_H
+
+#include "image.h"
+
+#include <cstdio>
+#include <mutex>
+
+// Archive of many programs, all fields little-endian:
+//   magic    4 bytes  "CTRB"
+//   version  uint16   bundleVersion
+//   reserved uint16
+//   count    uint32   number of entries
+//   index    count x { uint64 offset, uint32 image bytes, uint32 input count }
+//   entries  binary image (image.h) followed by its inputs as int32
+constexpr uint16_t bundleVersion{ 1 };
+constexpr size_t bundleHeaderSize{ 12 };
+constexpr size_t bundleIndexEntrySize{ 16 };
+
+// Collects programs in memory and writes them out as one bundle
+class BundleWriter {
+public:
+	// Adds the first 'count' words of memory, and optionally its inputs;
+	// returns the entry number
+	size_t add(const std::array<int, memorySize>& memory, size_t count,
+		const std::vector<int>& inputs = {});
+
+	size_t size() const;
+
+	void save(const std::string& filename) const;
+
+private:
+	struct Entry {
+		std::vector<uint8_t> image;
+		std::vector<int> inputs;
+	};
+
+	std::vector<Entry> entries;
+};
+
+// Random access to the entries of a bundle; only the index is read up front.
+// Safe to share between threads: on POSIX every read is a pread() at its own
+// offset, so concurrent loads do not serialize on a file position.
+class BundleReader {
+public:
+	explicit BundleReader(const std::string& filename);
+	~BundleReader();
+
+	BundleReader(const BundleReader&) = delete;
+	BundleReader& operator=(const BundleReader&) = delete;
+
+	size_t size() const;
+
+	// Loads entry 'n' into memory; returns the number of words loaded
+	size_t load(size_t n, std::array<int, memorySize>& memory) const;
+
+	std::vector<int> inputs(size_t n) const;
+
+private:
+	struct IndexEntry {
+		uint64_t offset;
+		uint32_t imageSize;
+		uint32_t inputCount;
+	};
+
+	void read(uint64_t offset, void* data, size_t size) const;
+
+#ifdef _WIN32
+	std::FILE* file{ nullptr };
+	mutable std::mutex mutex;
+#else
+	int fd{ -1 };
+#endif
+	uint64_t fileSize{ 0 };
+	std::vector<IndexEntry> index;
+};
+
+#endif // BUNDLE_H
@@ -0,0 +1,52 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+#include "jit.h"
+
+#include <mutex>
+#include <unordered_map>
+
+// A loaded program and everything derived from it. Shared between every
+// load of the same text; copy 'memory' before executing, as runs write to it.
+class CachedProgram {
+public:
+	CachedProgram(std::string text, const std::array<int, memorySize>& memory, size_t count);
+
+	const std::string& getText() const;
+	const std::array<int, memorySize>& getMemory() const;
+	size_t getCount() const;
+	const FusedProgram& getFused() const;
+
+	// Native code for entry point 0, compiled on first use
+	const JitProgram& getCompiled() const;
+
+private:
+	std::string text;
+	std::array<int, memorySize> memory;
+	size_t count;
+	FusedProgram fused;
+
+	mutable std::once_flag compileOnce;
+	mutable std::unique_ptr<JitProgram> compiled;
+};
+
+// Loaded programs keyed by a hash of their text, so resubmitting the same
+// program under another name skips parsing, validation and decoding. The
+// text is compared on a hash match, so a collision cannot return the wrong
+// program. Safe to share between threads.
+class ProgramCache {
+public:
+	std::shared_ptr<const CachedProgram> load(const std::string& filename);
+	std::shared_ptr<const CachedProgram> parse(std::string_view text);
+
+	size_t size() const;
+	size_t getHits() const;
+	void clear();
+
+private:
+	mutable std::mutex mutex;
+	std::unordered_multimap<size_t, std::shared_ptr<const CachedProgram>> programs;
+	size_t hits{ 0 };
+};
+
+#endif // CACHE_H
@@ -1,15 +1,47 @@
 #ifndef COMPUTRON_H
 #define COMPUTRON_H
 
+#include <chrono>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <array>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 
 constexpr size_t memorySize{ 100 };
 constexpr int minWord{ -9999 };
 constexpr int maxWord{ 9999 };
 
+// Compile-time layout of a machine with 'Cells' words of memory. The operand
+// is the low decimal digits, as many as it takes to address every cell, and
+// the two-digit opcode sits above it, so the word range grows with memory.
+// MachineConfig<memorySize> is the standard machine; the 1000 and 10000 cell
+// machines are instantiated in computron.cpp as well.
+template <size_t Cells>
+struct MachineConfig {
+	static_assert(Cells > 0 && Cells <= 10000, "Operands are at most four digits");
+
+	static constexpr size_t memorySize{ Cells };
+	static constexpr int operandBase{ Cells <= 10 ? 10 : Cells <= 100 ? 100 : Cells <= 1000 ? 1000 : 10000 };
+	static constexpr int operandDigits{ operandBase == 10 ? 1 : operandBase == 100 ? 2 : operandBase == 1000 ? 3 : 4 };
+	static constexpr int maxWord{ 100 * operandBase - 1 };
+	static constexpr int minWord{ -maxWord };
+
+	// Wide enough for the product of any two words
+	using Arithmetic = std::conditional_t<(static_cast<long long>(maxWord) * maxWord <= std::numeric_limits<int>::max()), int, long long>;
+
+	static constexpr bool validWord(Arithmetic word) {
+		return word >= minWord && word <= maxWord;
+	}
+};
+
+using StandardConfig = MachineConfig<memorySize>;
+static_assert(StandardConfig::minWord == minWord && StandardConfig::maxWord == maxWord);
+
 enum class Command {
 	read=10, write,
 	load = 20, store,
@@ -17,19 +49,297 @@ enum class Command {
 	branch = 40, branchNeg, branchZero, halt
 };
 
-void load_from_file(std::array<int, memorySize>& memory, const std::string& filename);
+// One memory cell decoded ahead of execution: the raw word plus the fields
+// execute() would otherwise recompute from it on every step
+struct DecodedInstruction {
+	int instruction{ 0 };
+	size_t operationCode{ 0 };
+	size_t operand{ 0 };
+	Command command{ Command::halt };
+};
+
+using DecodedProgram = std::array<DecodedInstruction, memorySize>;
+
+// Common instruction sequences executed as a single dispatch
+enum class Superinstruction {
+	none,
+	loadAddStore,           // load X; add Y; store Z
+	loadSubtractBranchZero, // load X; subtract Y; branchZero T
+	loadBranchNeg           // load X; branchNeg T
+};
+
+// Decoded program plus the superinstruction, if any, starting at each cell
+struct FusedProgram {
+	DecodedProgram decoded;
+	std::array<Superinstruction, memorySize> fused;
+};
+
+// A straight-line run of instructions ending at a branch, halt or fault
+struct BasicBlock {
+	size_t start{ 0 };
+	std::vector<DecodedInstruction> instructions;
+};
+
+// Translated basic blocks keyed by start address. A write into a cell drops
+// only the blocks that were translated from it; writes to data cost nothing.
+// lookup() checks a cached block's words against memory and retranslates it
+// if they differ, so one cache can serve runs of different images.
+class BlockCache {
+public:
+	const BasicBlock& lookup(const std::array<int, memorySize>& memory, size_t address);
+	void invalidate(size_t address);
+	bool cached(size_t address) const;
+	size_t size() const;
+
+private:
+	std::array<std::unique_ptr<BasicBlock>, memorySize> blocks;
+	std::array<std::vector<size_t>, memorySize> owners; // starts of the blocks covering each cell
+};
+
+Command opCodeToCommand(size_t opCode);
+
+DecodedInstruction decode(int instruction);
+
+void decode_program(const std::array<int, memorySize>& memory, DecodedProgram& program);
+
+void fuse_program(const std::array<int, memorySize>& memory, FusedProgram& program);
+
+// Cells reachable by control flow from 'entry'; everything else is data
+template <size_t Cells>
+std::array<bool, Cells> reachable_cells(const std::array<int, Cells>& memory, size_t entry);
+
+// Proves, for every cell reachable from 'entry', that the opcode is known,
+// the operand is inside memory, control cannot run past the last cell and no
+// read or store can overwrite reachable code. Such an image can run without
+// the per-step range and opcode checks.
+template <size_t Cells>
+bool verify_program(const std::array<int, Cells>& memory, size_t entry = 0);
+
+// Parses the text program format (one word per line, ending at -99999 or the
+// end of the text) into memory; returns the number of words loaded
+size_t parse_program(std::string_view text, std::array<int, memorySize>& memory);
+
+// Returns the number of words loaded. load_from_file(), execute(), dump()
+// and the machine are templates on the memory word type: int, or int16_t,
+// which holds every standard word in half the space. They are also templates
+// on the memory size, which selects the MachineConfig that decodes and
+// validates words.
+template <typename Word, size_t Cells>
+size_t load_from_file(std::array<Word, Cells>& memory, const std::string& filename);
+
+// Reads a program from a stream or a file descriptor up to and including the
+// -99999 sentinel line; whatever follows (e.g. input values) is left unread
+size_t load_from_stream(std::array<int, memorySize>& memory, std::istream& in);
+size_t load_from_fd(std::array<int, memorySize>& memory, int fd);
+
+// load_from_file() that parses the file through a read-only mmap instead of
+// copying it; falls back to load_from_file() where mmap is unavailable
+size_t load_from_mapped_file(std::array<int, memorySize>& memory, const std::string& filename);
+
+template <typename Word, size_t Cells>
+void execute(std::array<Word, Cells>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+
+void execute_decoded(std::array<int, memorySize>& memory, DecodedProgram& program,
+	int* const acPtr, size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+
+// Like execute_decoded(), but runs superinstructions in one step. A fault
+// inside one reports the faulting instruction exactly as execute() would.
+void execute_fused(std::array<int, memorySize>& memory, FusedProgram& program,
+	int* const acPtr, size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+
+// Runs whole cached basic blocks. The cache survives between runs: blocks whose
+// words still match memory are reused, so a fresh copy of a self-modifying
+// image runs its original code, not the patched code of an earlier run.
+void execute_cached(std::array<int, memorySize>& memory, BlockCache& cache,
+	int* const acPtr, size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+
+// Instructions executed and time spent in each cell by execute_profiled()
+struct Profile {
+	std::array<uint64_t, memorySize> counts{};
+	std::array<std::chrono::nanoseconds, memorySize> time{};
+};
+
+// execute() that also adds every step's count and elapsed time to the cell it
+// executed from. Profiles accumulate across runs until reset.
+void execute_profiled(std::array<int, memorySize>& memory, Profile& profile,
+	int* const acPtr, size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+
+// State shared between the host and compiled code: JIT output, or a program
+// built by NativeProgram::compile(). Compiled code addresses these fields by
+// fixed offsets, so the layout must not change.
+struct CompiledContext {
+	int* memory{ nullptr };
+	const int* inputs{ nullptr };
+	size_t inputCount{ 0 };
+	size_t inputIndex{ 0 };
+	size_t instructionCounter{ 0 };
+	int accumulator{ 0 };
+};
+
+// Runs compiled code from the current registers. The code leaves by a side
+// exit just before an instruction it does not handle; execute() resumes
+// there, so registers and errors are the ones execute() would have produced.
+void run_compiled(void (*function)(CompiledContext*),
+	std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
 
-void execute(std::array<int, memorySize>& memory, int* const acPtr,
+// Direct-threaded (computed goto) dispatch where the compiler supports it;
+// identical semantics and errors to execute()
+void execute_threaded(std::array<int, memorySize>& memory, int* const acPtr,
 	size_t* const icPtr, int* const irPtr,
 	size_t* const opCodePtr, size_t* const opPtr,
 	const std::vector<int>& inputs);
 
-void dump(std::array <int, memorySize> & memory, int accumulator,
+template <typename Word, size_t Cells>
+void dump(const std::array<Word, Cells>& memory, int accumulator,
 	size_t instructionCounter, size_t instructionRegister,
 	size_t operationCode, size_t operand);
 
 bool validWord(int word);
 
+// Index of the first of 'count' words outside [minWord, maxWord], or 'count'
+// when all are valid. Compares four words at a time where SSE2 is available.
+size_t find_invalid_word(const int* words, size_t count);
+
+// find_invalid_word over every cell of each image; memorySize marks a valid image
+std::vector<size_t> validate_images(const std::vector<std::array<int, memorySize>>& images);
+
 void output(std::string label, int width, int value, bool sign);
 
+// Final state of one run, as dump() would report it
+struct RunResult {
+	std::array<int, memorySize> memory{ 0 };
+	int accumulator{ 0 };
+	size_t instructionCounter{ 0 };
+	int instructionRegister{ 0 };
+	size_t operationCode{ 0 };
+	size_t operand{ 0 };
+	bool halted{ false };
+	std::string error; // the runtime_error execute() would have thrown, if any
+};
+
+// Default memory of a machine: one flat array of words. A memory policy has
+// read(), write(), assign() of a whole image, loadFile() of a text program
+// and snapshot() of the cells; PagedMemory in fork.h is the copy-on-write
+// alternative.
+template <typename Word, size_t Cells>
+class FlatMemory {
+public:
+	using Snapshot = const std::array<Word, Cells>&;
+
+	Word read(size_t address) const { return cells[address]; }
+	void write(size_t address, Word word) { cells[address] = word; }
+	void assign(const std::array<Word, Cells>& image) { cells = image; }
+
+	// load_from_file() straight into the cells; only the cells past the program are zeroed
+	void loadFile(const std::string& filename) {
+		for (size_t i = load_from_file(cells, filename); i < Cells; ++i) cells[i] = 0;
+	}
+
+	Snapshot snapshot() const { return cells; }
+
+private:
+	std::array<Word, Cells> cells{ 0 };
+};
+
+// A reusable machine: memory, registers and the input cursor live in one
+// object, so a job is load(), setInputs(), run() with no allocation once the
+// input buffer has grown to size. run() works on local copies of the
+// registers and stores them back when it returns or throws.
+template <typename Word, typename Config = StandardConfig, typename Memory = FlatMemory<Word, Config::memorySize>>
+class BasicComputron {
+	static_assert(std::numeric_limits<Word>::max() >= Config::maxWord, "Word cannot hold every valid word");
+
+public:
+	// Shadows the standard size, so the members below are sized by Config
+	static constexpr size_t memorySize{ Config::memorySize };
+
+	// Clears the registers, input cursor and verification; memory is left to load()
+	void reset();
+
+	// Replaces memory with 'image' and resets the registers
+	void load(const std::array<Word, memorySize>& image);
+
+	// Memory::loadFile(): for FlatMemory, load_from_file() into memory,
+	// zeroing only the cells past the program
+	void load(const std::string& filename);
+
+	// Copies 'values' into the input buffer, reusing its capacity
+	void setInputs(const std::vector<int>& values);
+
+	// Executes at most maxSteps instructions; true once the machine has halted
+	bool run(size_t maxSteps = std::numeric_limits<size_t>::max());
+
+	// Executes one instruction; true if it was a halt
+	bool step();
+
+	// Runs verify_program() from the current instruction counter; while the
+	// image stays verified, run() skips the per-step range and opcode checks.
+	// load() and reset() clear it.
+	bool verify();
+	bool isVerified() const;
+
+	// A machine in this exact state, inputs included. With PagedMemory the two
+	// share every page until either writes to it; otherwise memory is copied.
+	BasicComputron fork() const;
+
+	bool isHalted() const;
+	typename Memory::Snapshot getMemory() const;
+	const Memory& getStorage() const;
+	int getAccumulator() const;
+	size_t getInstructionCounter() const;
+	int getInstructionRegister() const;
+	size_t getOperationCode() const;
+	size_t getOperand() const;
+	size_t getInputIndex() const;
+
+	// Appends the whole machine state, input buffer and cursor included, to
+	// 'out' in the checkpoint format described in image.h
+	void checkpoint(std::vector<uint8_t>& out) const;
+
+	// Replaces the state with a checkpoint of a machine of the same Config.
+	// Throws runtime_error("invalid_input") on a bad blob and leaves the
+	// machine untouched; the restored image is unverified.
+	void restore(const uint8_t* data, size_t size);
+
+	void dump() const;
+
+private:
+	Memory memory;
+	std::vector<int> inputs;
+	int accumulator{ 0 };
+	size_t instructionCounter{ 0 };
+	int instructionRegister{ 0 };
+	size_t operationCode{ 0 };
+	size_t operand{ 0 };
+	size_t inputIndex{ 0 };
+	bool halted{ false };
+	bool verified{ false };
+
+	template <bool checked>
+	bool runLoop(size_t maxSteps);
+};
+
+using Computron = BasicComputron<int>;
+using CompactComputron = BasicComputron<int16_t>;
+using Computron1000 = BasicComputron<int, MachineConfig<1000>>;
+using Computron10000 = BasicComputron<int, MachineConfig<10000>>;
+
+// Runs a loaded machine until it halts or throws and returns its final state;
+// the runtime_error, if any, becomes RunResult::error
+RunResult run_to_result(Computron& computron);
+
 #endif // COMPUTRON_H
\ No newline at end of file
@@ -0,0 +1,46 @@
+#ifndef FLEET_H
+#define FLEET_H
+
+#include "computron.h"
+
+#include <deque>
+#include <mutex>
+
+// One program image and the inputs to run it with
+struct FleetJob {
+	std::array<int, memorySize> image{ 0 };
+	std::vector<int> inputs;
+};
+
+// Runs queued jobs across worker threads. Jobs are dealt out round-robin to
+// per-worker deques; a worker takes from the back of its own deque and, once
+// it runs dry, steals from the front of the others, so a few long-running
+// jobs cannot leave the remaining workers idle.
+class FleetRunner {
+public:
+	// 0 uses one worker per hardware thread
+	explicit FleetRunner(size_t threads = 0);
+
+	// Queues a job; returns its index in the results of the next run()
+	size_t submit(FleetJob job);
+
+	// Executes every queued job and returns the results in submission order
+	std::vector<RunResult> run();
+
+	size_t getThreadCount() const;
+
+private:
+	struct WorkQueue {
+		std::mutex mutex;
+		std::deque<size_t> jobs;
+	};
+
+	bool take(size_t worker, size_t& job);
+	void work(size_t worker, std::vector<RunResult>& results);
+
+	size_t threadCount;
+	std::vector<FleetJob> jobs;
+	std::deque<WorkQueue> queues;
+};
+
+#endif // FLEET_H
@@ -0,0 +1,149 @@
+#ifndef FORK_H
+#define FORK_H
+
+#include "computron.h"
+
+#include <algorithm>
+#include <atomic>
+
+// Memory policy that splits the cells into reference-counted pages, so
+// copying a machine - fork() - copies only the page table. A page is cloned
+// the first time a machine writes to it while another machine still holds it;
+// pages nobody writes stay shared for good. Each machine belongs to one thread
+// at a time, but forks of one machine may run on different threads: a writer
+// that finds itself the only owner acquires every other owner's release of
+// the page, so their last reads of it happen before the write.
+template <typename Word, size_t Cells>
+class PagedMemory {
+public:
+	using Snapshot = std::array<Word, Cells>;
+
+	// One 64-byte cache line per page
+	static constexpr size_t pageSize{ 64 / sizeof(Word) };
+	static constexpr size_t pageCount{ (Cells + pageSize - 1) / pageSize };
+
+	PagedMemory();
+	PagedMemory(const PagedMemory& other);
+	PagedMemory& operator=(const PagedMemory& other);
+	~PagedMemory();
+
+	Word read(size_t address) const { return pages[address / pageSize]->cells[address % pageSize]; }
+
+	void write(size_t address, Word word) {
+		// Only this machine can add owners to a page it holds alone, so a
+		// count of one cannot go stale
+		Page*& page = pages[address / pageSize];
+		if (page->owners.load(std::memory_order_acquire) != 1) page = clone(page);
+		page->cells[address % pageSize] = word;
+	}
+
+	// Fresh pages, so machines forked from the old image keep theirs
+	void assign(const std::array<Word, Cells>& image);
+	void loadFile(const std::string& filename);
+	Snapshot snapshot() const;
+
+	// Pages this machine currently shares with at least one other machine
+	size_t sharedPages() const;
+
+private:
+	struct Page {
+		std::atomic<size_t> owners{ 1 };
+		std::array<Word, pageSize> cells{ 0 };
+	};
+
+	// A private copy of 'page'; gives up this machine's share of the original
+	static Page* clone(Page* page);
+	static void release(Page* page);
+
+	std::array<Page*, pageCount> pages;
+};
+
+template <typename Word, size_t Cells>
+PagedMemory<Word, Cells>::PagedMemory() {
+	for (Page*& page : pages) {
+		page = new Page;
+	}
+}
+
+template <typename Word, size_t Cells>
+PagedMemory<Word, Cells>::PagedMemory(const PagedMemory& other) : pages(other.pages) {
+	// New owners come only from a machine that holds the page, so relaxed is enough
+	for (Page* page : pages) {
+		page->owners.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+template <typename Word, size_t Cells>
+PagedMemory<Word, Cells>& PagedMemory<Word, Cells>::operator=(const PagedMemory& other) {
+	// Take the new shares before dropping the old ones, so self-assignment is safe
+	for (Page* page : other.pages) {
+		page->owners.fetch_add(1, std::memory_order_relaxed);
+	}
+	for (Page* page : pages) {
+		release(page);
+	}
+	pages = other.pages;
+	return *this;
+}
+
+template <typename Word, size_t Cells>
+PagedMemory<Word, Cells>::~PagedMemory() {
+	for (Page* page : pages) {
+		release(page);
+	}
+}
+
+template <typename Word, size_t Cells>
+auto PagedMemory<Word, Cells>::clone(Page* page) -> Page* {
+	Page* copy = new Page;
+	copy->cells = page->cells;
+	release(page);
+	return copy;
+}
+
+template <typename Word, size_t Cells>
+void PagedMemory<Word, Cells>::release(Page* page) {
+	// Release publishes this owner's reads of the page to whoever writes it next
+	if (page->owners.fetch_sub(1, std::memory_order_acq_rel) == 1) delete page;
+}
+
+template <typename Word, size_t Cells>
+void PagedMemory<Word, Cells>::assign(const std::array<Word, Cells>& image) {
+	for (size_t p = 0; p < pageCount; ++p) {
+		Page* page = new Page;
+		const size_t first = p * pageSize;
+		std::copy_n(image.begin() + first, std::min(pageSize, Cells - first), page->cells.begin());
+		release(pages[p]);
+		pages[p] = page;
+	}
+}
+
+template <typename Word, size_t Cells>
+void PagedMemory<Word, Cells>::loadFile(const std::string& filename) {
+	// Every page is replaced anyway, so the image is read whole and then assigned
+	std::array<Word, Cells> image{ 0 };
+	load_from_file(image, filename);
+	assign(image);
+}
+
+template <typename Word, size_t Cells>
+auto PagedMemory<Word, Cells>::snapshot() const -> Snapshot {
+	Snapshot cells;
+	for (size_t p = 0; p < pageCount; ++p) {
+		const size_t first = p * pageSize;
+		std::copy_n(pages[p]->cells.begin(), std::min(pageSize, Cells - first), cells.begin() + first);
+	}
+	return cells;
+}
+
+template <typename Word, size_t Cells>
+size_t PagedMemory<Word, Cells>::sharedPages() const {
+	return static_cast<size_t>(std::count_if(pages.begin(), pages.end(),
+		[](const Page* page) { return page->owners.load(std::memory_order_relaxed) > 1; }));
+}
+
+using ForkableMemory = PagedMemory<int, memorySize>;
+using ForkableComputron = BasicComputron<int, StandardConfig, ForkableMemory>;
+using CompactForkableComputron = BasicComputron<int16_t, StandardConfig, PagedMemory<int16_t, memorySize>>;
+
+#endif // FORK_H
@@ -0,0 +1,47 @@
+#ifndef IMAGE_H
+#define IMAGE_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+// Binary program image, all fields little-endian:
+//   magic     4 bytes  "CTRN"
+//   version   uint16   imageVersion
+//   count     uint16   number of words
+//   checksum  uint32   FNV-1a of the word bytes
+//   words     int16 x count (every valid word fits in +-9999)
+constexpr uint16_t imageVersion{ 1 };
+constexpr size_t imageHeaderSize{ 12 };
+
+// Machine checkpoint, all fields little-endian:
+//   magic        4 bytes  "CTCK"
+//   version      uint16   checkpointVersion
+//   cells        uint16   memory size of the machine
+//   checksum     uint32   FNV-1a of everything after the header
+//   accumulator, instructionCounter, instructionRegister  int32 each
+//   operationCode, operand  uint64 each
+//   inputIndex   uint32
+//   halted       uint8
+//   wordBytes    uint8    2, or 4 when some memory word exceeds +-32767
+//   inputCount   uint32, then the inputs as int32 x inputCount
+//   memory       int16 or int32 x cells
+constexpr uint16_t checkpointVersion{ 1 };
+constexpr size_t checkpointHeaderSize{ 12 };
+
+// Appends the image of the first 'count' words of memory to 'out'
+void encode_image(const std::array<int, memorySize>& memory, size_t count, std::vector<uint8_t>& out);
+
+// Decodes an image from 'size' bytes at 'data'; returns the number of words
+// loaded. Throws runtime_error("invalid_input") on a bad header, checksum or word.
+size_t decode_image(const uint8_t* data, size_t size, std::array<int, memorySize>& memory);
+
+void save_image(const std::array<int, memorySize>& memory, size_t count, const std::string& filename);
+
+// Loads a binary image the way load_from_file() loads a text program
+size_t load_image(std::array<int, memorySize>& memory, const std::string& filename);
+
+// Converts a text program read by load_from_file() into a binary image
+void convert_text_to_image(const std::string& textFile, const std::string& imageFile);
+
+#endif // IMAGE_H
@@ -0,0 +1,73 @@
+#ifndef INTERACTIVE_H
+#define INTERACTIVE_H
+
+#include "computron.h"
+
+#include <coroutine>
+#include <deque>
+#include <exception>
+
+// Bounded FIFO of words between an interactive machine and its host
+class Channel {
+public:
+	explicit Channel(size_t capacity = std::numeric_limits<size_t>::max());
+
+	bool empty() const;
+	bool full() const;
+	size_t size() const;
+
+	// false if the channel is full
+	bool push(int value);
+	// Throws if the channel is empty
+	int pop();
+
+private:
+	size_t capacity;
+	std::deque<int> values;
+};
+
+// Why a suspended interactive machine is waiting
+enum class Suspension { none, input, output };
+
+// Handle to a suspended execute_interactive() run. resume() runs the machine
+// until it halts or has to wait, and rethrows any runtime_error it raised.
+class ComputronTask {
+public:
+	struct promise_type {
+		Suspension waiting{ Suspension::none };
+		std::exception_ptr error;
+
+		ComputronTask get_return_object();
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		std::suspend_always final_suspend() noexcept { return {}; }
+		void return_void() {}
+		void unhandled_exception() { error = std::current_exception(); }
+	};
+
+	explicit ComputronTask(std::coroutine_handle<promise_type> handle);
+	ComputronTask(ComputronTask&& other) noexcept;
+	ComputronTask& operator=(ComputronTask&& other) noexcept;
+	~ComputronTask();
+
+	ComputronTask(const ComputronTask&) = delete;
+	ComputronTask& operator=(const ComputronTask&) = delete;
+
+	// true while the machine has not halted
+	bool resume();
+	bool done() const;
+	Suspension waitingFor() const;
+
+private:
+	std::coroutine_handle<promise_type> handle;
+};
+
+// Coroutine variant of execute() fed from channels: read suspends while
+// 'input' is empty and write, which pushes memory[operand] to 'output',
+// suspends while 'output' is full. Memory, registers and channels must
+// outlive the task. Nothing runs until the first resume().
+ComputronTask execute_interactive(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	Channel& input, Channel& output);
+
+#endif // INTERACTIVE_H
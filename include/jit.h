@@ -0,0 +1,43 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include "computron.h"
+
+#include <cstdint>
+
+// Native x86-64 translation of the code reachable from an entry point.
+// Every instruction that could fault, halt or write into the compiled code
+// becomes a side exit that hands the machine back to execute() at exactly
+// that instruction, so errors and final registers match the interpreter.
+class JitProgram {
+public:
+	JitProgram(const std::array<int, memorySize>& memory, size_t entry);
+	~JitProgram();
+
+	JitProgram(const JitProgram&) = delete;
+	JitProgram& operator=(const JitProgram&) = delete;
+
+	// false when the host is not x86-64 or executable memory is unavailable
+	bool compiled() const;
+
+	void run(std::array<int, memorySize>& memory, int* const acPtr,
+		size_t* const icPtr, int* const irPtr,
+		size_t* const opCodePtr, size_t* const opPtr,
+		const std::vector<int>& inputs) const;
+
+private:
+	using EntryPoint = void (*)(CompiledContext*);
+
+	size_t entry;
+	std::array<bool, memorySize> isCode{};
+	std::array<int, memorySize> codeWords{};
+	void* code{ nullptr };
+	size_t codeSize{ 0 };
+};
+
+void execute_jit(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr,
+	size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+
+#endif // JIT_H
@@ -0,0 +1,23 @@
+#ifndef LOADER_H
+#define LOADER_H
+
+#include "bundle.h"
+
+// One program from a bulk load; 'error' is empty when it loaded cleanly
+struct LoadedProgram {
+	std::string source; // file path, or "<bundle>#n" for bundle entries
+	std::array<int, memorySize> memory{ 0 };
+	size_t count{ 0 };
+	std::string error;
+};
+
+// Loads every regular file in 'directory' in parallel: files ending in .img
+// with load_image(), everything else with load_from_file(). A bad file is
+// reported in its own entry instead of stopping the load. Results are sorted
+// by path. 0 threads uses one per hardware thread.
+std::vector<LoadedProgram> load_directory(const std::string& directory, size_t threads = 0);
+
+// Loads every entry of a bundle in parallel
+std::vector<LoadedProgram> load_bundle(const BundleReader& bundle, size_t threads = 0);
+
+#endif // LOADER_H
@@ -0,0 +1,46 @@
+#ifndef NATIVE_H
+#define NATIVE_H
+
+#include "computron.h"
+
+#include <ostream>
+
+// Writes a C++ translation of the code reachable from 'entry': one function
+// per program, one label per basic block. Instructions that halt, fault or
+// write into the program's own code leave the function with the instruction
+// counter pointing at them, for the interpreter to execute.
+void translate_to_cpp(const std::array<int, memorySize>& memory, std::ostream& out, size_t entry = 0);
+
+// A translated program compiled into a shared object and loaded with dlopen
+class NativeProgram {
+public:
+	// Loads a shared object produced by compile()
+	explicit NativeProgram(const std::string& libraryPath);
+	~NativeProgram();
+
+	NativeProgram(const NativeProgram&) = delete;
+	NativeProgram& operator=(const NativeProgram&) = delete;
+
+	// Translates 'memory' into '<libraryPath>.cpp' and builds it into 'libraryPath'
+	// with the system compiler ($CXX, or c++)
+	static void compile(const std::array<int, memorySize>& memory,
+		const std::string& libraryPath, size_t entry = 0);
+
+	// Runs the program, resuming in execute() after any side exit, so registers
+	// and errors are the ones execute() would have produced
+	void run(std::array<int, memorySize>& memory, int* const acPtr,
+		size_t* const icPtr, int* const irPtr,
+		size_t* const opCodePtr, size_t* const opPtr,
+		const std::vector<int>& inputs) const;
+
+private:
+	using EntryPoint = void (*)(CompiledContext*);
+
+	void* library{ nullptr };
+	EntryPoint function{ nullptr };
+	const int* codeWords{ nullptr };
+	const unsigned char* isCode{ nullptr };
+	size_t entry{ 0 };
+};
+
+#endif // NATIVE_H
@@ -0,0 +1,246 @@
+#include "assembler.h"
+
+#include <cctype>
+#include <charconv>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace {
+
+struct Mnemonic {
+	const char* name;
+	Command command;
+};
+
+constexpr Mnemonic mnemonics[]{
+	{ "READ", Command::read },         { "WRITE", Command::write },
+	{ "LOAD", Command::load },         { "STORE", Command::store },
+	{ "ADD", Command::add },           { "SUB", Command::subtract },
+	{ "DIV", Command::divide },        { "MUL", Command::multiply },
+	{ "BR", Command::branch },         { "BRNEG", Command::branchNeg },
+	{ "BRZ", Command::branchZero },    { "HALT", Command::halt }
+};
+
+[[noreturn]] void fail(size_t line, const std::string& message) {
+	throw std::runtime_error("Line " + std::to_string(line) + ": " + message);
+}
+
+bool isLabel(std::string_view token) {
+	if (token.empty() || std::isdigit(static_cast<unsigned char>(token[0]))) return false;
+	for (char c : token) {
+		if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+	}
+	return true;
+}
+
+bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+	if (a.size() != b.size()) return false;
+	for (size_t i = 0; i < a.size(); ++i) {
+		if (std::toupper(static_cast<unsigned char>(a[i])) != b[i]) return false;
+	}
+	return true;
+}
+
+// Whether the word can be listed as an instruction and assembled back unchanged
+bool isInstruction(int word) {
+	if (word < 0) return false;
+	const DecodedInstruction decoded = decode(word);
+	return static_cast<size_t>(decoded.command) == decoded.operationCode;
+}
+
+std::string cellLabel(size_t address) {
+	std::ostringstream oss;
+	oss << 'L' << std::setw(2) << std::setfill('0') << address;
+	return oss.str();
+}
+
+// Splits a line into whitespace-separated tokens, dropping any comment
+std::vector<std::string_view> tokenize(std::string_view line) {
+	line = line.substr(0, line.find(';'));
+
+	std::vector<std::string_view> tokens;
+	size_t i{ 0 };
+	while (i < line.size()) {
+		while (i < line.size() && std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+		const size_t start = i;
+		while (i < line.size() && !std::isspace(static_cast<unsigned char>(line[i]))) ++i;
+		if (i > start) tokens.push_back(line.substr(start, i - start));
+	}
+	return tokens;
+}
+
+// A cell whose operand names a label, patched once every label is known
+struct Fixup {
+	size_t address;
+	size_t line;
+	std::string label;
+};
+
+} // namespace
+
+const char* mnemonic(Command command) {
+	for (const Mnemonic& m : mnemonics) {
+		if (m.command == command) return m.name;
+	}
+	return "HALT";
+}
+
+size_t assemble(std::string_view source, std::array<int, memorySize>& memory) {
+	std::unordered_map<std::string, size_t> labels;
+	std::vector<Fixup> fixups;
+	size_t count{ 0 };
+	size_t line{ 0 };
+
+	while (!source.empty()) {
+		++line;
+		const size_t newline = source.find('\n');
+		const std::string_view text = source.substr(0, newline);
+		source = newline == std::string_view::npos ? std::string_view{} : source.substr(newline + 1);
+
+		std::vector<std::string_view> tokens = tokenize(text);
+		if (tokens.empty()) continue;
+
+		if (tokens[0].back() == ':') {
+			const std::string_view label = tokens[0].substr(0, tokens[0].size() - 1);
+			if (!isLabel(label)) fail(line, "bad label " + std::string(label));
+			if (!labels.emplace(std::string(label), count).second)
+				fail(line, "duplicate label " + std::string(label));
+			tokens.erase(tokens.begin());
+			if (tokens.empty()) continue;
+		}
+
+		const std::string_view name = tokens[0];
+		const bool isData = equalsIgnoreCase(name, "DATA");
+		const Mnemonic* found{ nullptr };
+		for (const Mnemonic& m : mnemonics) {
+			if (equalsIgnoreCase(name, m.name)) found = &m;
+		}
+		if (!isData && !found) fail(line, "unknown mnemonic " + std::string(name));
+
+		const bool operandOptional = found && found->command == Command::halt;
+		if (tokens.size() > 2) fail(line, "too many operands");
+		if (tokens.size() < 2 && !operandOptional) fail(line, "missing operand");
+		if (count >= memorySize) fail(line, "program does not fit in memory");
+
+		int value{ 0 };
+		if (tokens.size() == 2) {
+			std::string_view operand = tokens[1];
+			if (isLabel(operand)) {
+				fixups.push_back({ count, line, std::string(operand) });
+			}
+			else {
+				if (operand.size() > 1 && operand[0] == '+') operand.remove_prefix(1);
+				const auto result = std::from_chars(operand.data(), operand.data() + operand.size(), value);
+				if (result.ec != std::errc() || result.ptr != operand.data() + operand.size())
+					fail(line, "bad operand " + std::string(tokens[1]));
+			}
+		}
+
+		if (isData) {
+			if (!validWord(value)) fail(line, "word out of range");
+			memory[count] = value;
+		}
+		else {
+			if (value < 0 || static_cast<size_t>(value) >= memorySize) fail(line, "operand out of range");
+			memory[count] = static_cast<int>(found->command) * 100 + value;
+		}
+		++count;
+	}
+
+	for (const Fixup& fixup : fixups) {
+		const auto label = labels.find(fixup.label);
+		if (label == labels.end()) fail(fixup.line, "undefined label " + fixup.label);
+		if (label->second >= memorySize) fail(fixup.line, "operand out of range");
+		memory[fixup.address] += static_cast<int>(label->second);
+	}
+	return count;
+}
+
+void write_program(const std::array<int, memorySize>& memory, size_t count, std::ostream& out) {
+	for (size_t i = 0; i < count && i < memorySize; ++i) {
+		out << memory[i] << '\n';
+	}
+	out << -99999 << '\n';
+}
+
+void assemble_file(const std::string& sourceFile, const std::string& programFile) {
+	std::ifstream in(sourceFile);
+	if (!in) throw std::runtime_error("Cannot read " + sourceFile);
+	std::ostringstream source;
+	source << in.rdbuf();
+
+	std::array<int, memorySize> memory{ 0 };
+	const size_t count = assemble(source.str(), memory);
+
+	std::ofstream out(programFile);
+	if (!out) throw std::runtime_error("Cannot write " + programFile);
+	write_program(memory, count, out);
+}
+
+void disassemble(const std::array<int, memorySize>& memory, std::ostream& out,
+		size_t entry, const Profile* profile) {
+
+	const std::array<bool, memorySize> reachable = entry < memorySize
+		? reachable_cells(memory, entry) : std::array<bool, memorySize>{};
+
+	std::array<bool, memorySize> isCode{};
+	std::array<bool, memorySize> isTarget{};
+	size_t end{ 0 };
+	for (size_t address = 0; address < memorySize; ++address) {
+		isCode[address] = reachable[address] && isInstruction(memory[address]);
+
+		const DecodedInstruction decoded = decode(memory[address]);
+		if (isCode[address] && (decoded.command == Command::branch ||
+			decoded.command == Command::branchNeg || decoded.command == Command::branchZero)) {
+			isTarget[decoded.operand] = true;
+		}
+	}
+
+	// A branch may target a zero cell past the program; it still needs its label line
+	for (size_t address = 0; address < memorySize; ++address) {
+		if (isCode[address] || isTarget[address] || memory[address] != 0) end = address + 1;
+	}
+
+	std::chrono::nanoseconds total{ 0 };
+	if (profile) {
+		for (const std::chrono::nanoseconds& time : profile->time) total += time;
+	}
+
+	for (size_t address = 0; address < end; ++address) {
+		const DecodedInstruction decoded = decode(memory[address]);
+
+		std::ostringstream statement;
+		statement << std::left << std::setw(6) << (isTarget[address] ? cellLabel(address) + ":" : "");
+		if (!isCode[address]) {
+			statement << std::setw(6) << "DATA" << memory[address];
+		}
+		else {
+			statement << std::setw(6) << mnemonic(decoded.command);
+			if (isTarget[decoded.operand] && (decoded.command == Command::branch ||
+				decoded.command == Command::branchNeg || decoded.command == Command::branchZero)) {
+				statement << cellLabel(decoded.operand);
+			}
+			else if (decoded.command != Command::halt || decoded.operand != 0) {
+				statement << std::right << std::setw(2) << std::setfill('0') << decoded.operand;
+			}
+		}
+
+		out << std::left << std::setw(20) << statement.str() << std::right << "; "
+			<< std::setw(2) << std::setfill('0') << address << std::setfill(' ') << ": "
+			<< std::showpos << std::internal << std::setw(5) << std::setfill('0') << memory[address]
+			<< std::noshowpos << std::right << std::setfill(' ');
+
+		if (profile && profile->counts[address] != 0) {
+			const double micros = std::chrono::duration<double, std::micro>(profile->time[address]).count();
+			const double share = total.count() ? 100.0 * profile->time[address].count() / total.count() : 0.0;
+			out << std::fixed << std::setprecision(3)
+				<< "  x" << std::left << std::setw(8) << profile->counts[address] << std::right
+				<< std::setw(9) << micros << "us" << std::setprecision(1) << std::setw(6) << share << "%"
+				<< std::defaultfloat;
+		}
+		out << '\n';
+	}
+}
@@ -0,0 +1,444 @@
+#include "batch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// Lanes run together in chunks small enough for the chunk's memories to stay in cache
+constexpr size_t chunkLanes{ 256 };
+
+enum LaneStatus : int32_t {
+	running,
+	halted,
+	instructionCounterOutOfRange,
+	operandOutOfRange,
+	notEnoughInput,
+	invalidWord,
+	additionOutOfRange,
+	subtractionOutOfRange,
+	multiplicationOutOfRange,
+	divisionByZero,
+	divisionOutOfRange
+};
+
+const char* statusMessage(int32_t status) {
+	switch (status) {
+	case instructionCounterOutOfRange: return "Instruction counter out of range";
+	case operandOutOfRange: return "Operand out of range";
+	case notEnoughInput: return "Not enough input values";
+	case invalidWord: return "Invalid word";
+	case additionOutOfRange: return "Addition out of range";
+	case subtractionOutOfRange: return "Subtraction out of range";
+	case multiplicationOutOfRange: return "Multiplication out of range";
+	case divisionByZero: return "Division by 0";
+	case divisionOutOfRange: return "Division out of range";
+	default: return "";
+	}
+}
+
+// The integer operations the lane kernels need, on 'width' int32 lanes at a
+// time. Masks are all ones or all zeros per lane. Cells are int16_t in
+// memory and sign-extended on load. mul() takes operands that fit int16_t,
+// which every valid word and accumulator does.
+struct ScalarLanes {
+	using V = int32_t;
+	static constexpr size_t width{ 1 };
+
+	static V set1(int32_t x) { return x; }
+	static V load(const int32_t* p) { return *p; }
+	static void store(int32_t* p, V v) { *p = v; }
+	static V loadCells(const int16_t* p) { return *p; }
+	static void storeCells(int16_t* p, V mask, V v) { *p = mask ? static_cast<int16_t>(v) : *p; }
+	static V add(V a, V b) { return a + b; }
+	static V sub(V a, V b) { return a - b; }
+	static V mul(V a, V b) { return a * b; }
+	static V div(V a, V b) { return a / b; }
+	static V eq(V a, V b) { return a == b ? -1 : 0; }
+	static V lt(V a, V b) { return a < b ? -1 : 0; }
+	static V gt(V a, V b) { return a > b ? -1 : 0; }
+	static V both(V a, V b) { return a & b; }
+	static V either(V a, V b) { return a | b; }
+	static V unless(V a, V b) { return ~a & b; } // b and not a
+	static V select(V mask, V a, V b) { return (mask & a) | (~mask & b); }
+};
+
+#if defined(__SSE2__) || defined(_M_X64)
+struct Sse2Lanes {
+	using V = __m128i;
+	static constexpr size_t width{ 4 };
+
+	static V set1(int32_t x) { return _mm_set1_epi32(x); }
+	static V load(const int32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+	static void store(int32_t* p, V v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+
+	static V loadCells(const int16_t* p) {
+		const __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+		return _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16);
+	}
+
+	static void storeCells(int16_t* p, V mask, V v) {
+		const __m128i old = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p));
+		const __m128i words = select(_mm_packs_epi32(mask, mask), _mm_packs_epi32(v, v), old);
+		_mm_storel_epi64(reinterpret_cast<__m128i*>(p), words);
+	}
+
+	static V add(V a, V b) { return _mm_add_epi32(a, b); }
+	static V sub(V a, V b) { return _mm_sub_epi32(a, b); }
+
+	// No 32-bit multiply before SSE4.1: multiply as int16 and interleave the halves
+	static V mul(V a, V b) {
+		const __m128i a16 = _mm_packs_epi32(a, a);
+		const __m128i b16 = _mm_packs_epi32(b, b);
+		return _mm_unpacklo_epi16(_mm_mullo_epi16(a16, b16), _mm_mulhi_epi16(a16, b16));
+	}
+
+	// Doubles hold every quotient of two words exactly enough to truncate
+	static V div(V a, V b) {
+		const __m128i low = _mm_cvttpd_epi32(_mm_div_pd(_mm_cvtepi32_pd(a), _mm_cvtepi32_pd(b)));
+		const __m128i high = _mm_cvttpd_epi32(_mm_div_pd(
+			_mm_cvtepi32_pd(_mm_shuffle_epi32(a, 0xEE)), _mm_cvtepi32_pd(_mm_shuffle_epi32(b, 0xEE))));
+		return _mm_unpacklo_epi64(low, high);
+	}
+
+	static V eq(V a, V b) { return _mm_cmpeq_epi32(a, b); }
+	static V lt(V a, V b) { return _mm_cmplt_epi32(a, b); }
+	static V gt(V a, V b) { return _mm_cmpgt_epi32(a, b); }
+	static V both(V a, V b) { return _mm_and_si128(a, b); }
+	static V either(V a, V b) { return _mm_or_si128(a, b); }
+	static V unless(V a, V b) { return _mm_andnot_si128(a, b); }
+	static V select(V mask, V a, V b) { return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b)); }
+};
+#endif
+
+#if defined(__AVX2__)
+struct Avx2Lanes {
+	using V = __m256i;
+	static constexpr size_t width{ 8 };
+
+	static V set1(int32_t x) { return _mm256_set1_epi32(x); }
+	static V load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+	static void store(int32_t* p, V v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+
+	static V loadCells(const int16_t* p) {
+		return _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+	}
+
+	// packs works within 128-bit halves; the permute brings the eight words together
+	static __m128i narrow(V v) {
+		return _mm256_castsi256_si128(_mm256_permute4x64_epi64(_mm256_packs_epi32(v, v), 0x08));
+	}
+
+	static void storeCells(int16_t* p, V mask, V v) {
+		const __m128i old = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm_blendv_epi8(old, narrow(v), narrow(mask)));
+	}
+
+	static V add(V a, V b) { return _mm256_add_epi32(a, b); }
+	static V sub(V a, V b) { return _mm256_sub_epi32(a, b); }
+	static V mul(V a, V b) { return _mm256_mullo_epi32(a, b); }
+
+	static V div(V a, V b) {
+		const __m128i low = _mm256_cvttpd_epi32(_mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_castsi256_si128(a)), _mm256_cvtepi32_pd(_mm256_castsi256_si128(b))));
+		const __m128i high = _mm256_cvttpd_epi32(_mm256_div_pd(
+			_mm256_cvtepi32_pd(_mm256_extracti128_si256(a, 1)), _mm256_cvtepi32_pd(_mm256_extracti128_si256(b, 1))));
+		return _mm256_inserti128_si256(_mm256_castsi128_si256(low), high, 1);
+	}
+
+	static V eq(V a, V b) { return _mm256_cmpeq_epi32(a, b); }
+	static V lt(V a, V b) { return _mm256_cmpgt_epi32(b, a); }
+	static V gt(V a, V b) { return _mm256_cmpgt_epi32(a, b); }
+	static V both(V a, V b) { return _mm256_and_si256(a, b); }
+	static V either(V a, V b) { return _mm256_or_si256(a, b); }
+	static V unless(V a, V b) { return _mm256_andnot_si256(a, b); }
+	static V select(V mask, V a, V b) { return _mm256_blendv_epi8(b, a, mask); }
+};
+#endif
+
+// The widest kernels the target was compiled for
+#if defined(__AVX2__)
+using LaneOps = Avx2Lanes;
+#elif defined(__SSE2__) || defined(_M_X64)
+using LaneOps = Sse2Lanes;
+#else
+using LaneOps = ScalarLanes;
+#endif
+
+// Structure-of-arrays state for one chunk. Memory is cell-major, so a cell
+// across all lanes is contiguous: cells[address * stride + lane]. Cells are
+// int16_t, which holds every valid word, so a chunk needs half the cache;
+// every other lane field is int32_t, so one vector covers the same lanes in
+// each. 'stride' pads the lanes to whole vectors; padding lanes never run.
+struct Lanes {
+	size_t lanes{ 0 };
+	size_t stride{ 0 };
+	std::vector<int16_t> cells;
+	std::vector<int32_t> accumulator;
+	std::vector<int32_t> instructionCounter;
+	std::vector<int32_t> instructionRegister;
+	std::vector<int32_t> operationCode; // decode()'s size_t values, wrapped to 32 bits
+	std::vector<int32_t> operand;
+	std::vector<int32_t> status;
+	std::vector<int32_t> mask;
+	std::vector<size_t> inputIndex;
+};
+
+// Arithmetic kernel shared by add, subtract and multiply
+template <typename Ops, typename Operation>
+void arithmetic(Lanes& s, const int16_t* cell, int32_t error, Operation operation) {
+	using V = typename Ops::V;
+	const V below = Ops::set1(minWord);
+	const V above = Ops::set1(maxWord);
+	const V code = Ops::set1(error);
+
+	for (size_t l = 0; l < s.stride; l += Ops::width) {
+		const V mask = Ops::load(&s.mask[l]);
+		const V accumulator = Ops::load(&s.accumulator[l]);
+		const V word = operation(accumulator, Ops::loadCells(cell + l));
+		const V bad = Ops::either(Ops::lt(word, below), Ops::gt(word, above));
+		const V ok = Ops::unless(bad, mask);
+		Ops::store(&s.status[l], Ops::select(Ops::both(mask, bad), code, Ops::load(&s.status[l])));
+		Ops::store(&s.accumulator[l], Ops::select(ok, word, accumulator));
+		Ops::store(&s.instructionCounter[l], Ops::sub(Ops::load(&s.instructionCounter[l]), ok));
+	}
+}
+
+template <typename Ops>
+void run_chunk(Lanes& s, const std::vector<std::vector<int>>& inputs, size_t firstLane) {
+	using V = typename Ops::V;
+	const size_t lanes = s.lanes;
+	const V zero = Ops::set1(0);
+	const V one = Ops::set1(1);
+	const V active = Ops::set1(running);
+
+	for (;;) {
+		// Reconverge at the smallest instruction counter among running lanes
+		int32_t pc = static_cast<int32_t>(memorySize) + 1;
+		size_t leader = lanes;
+		for (size_t l = 0; l < lanes; ++l) {
+			if (s.status[l] == running && s.instructionCounter[l] < pc) {
+				pc = s.instructionCounter[l];
+				leader = l;
+			}
+		}
+		if (leader == lanes) return;
+
+		if (static_cast<size_t>(pc) >= memorySize) {
+			for (size_t l = 0; l < lanes; ++l) {
+				if (s.status[l] == running) s.status[l] = instructionCounterOutOfRange;
+			}
+			return;
+		}
+
+		// Lanes that rewrote this cell wait for a later step with their own word
+		const int16_t* code = &s.cells[static_cast<size_t>(pc) * s.stride];
+		const int instruction = code[leader];
+		const DecodedInstruction decoded = decode(instruction);
+		const V pcs = Ops::set1(pc);
+		const V instructions = Ops::set1(instruction);
+		const V opCodes = Ops::set1(static_cast<int32_t>(decoded.operationCode));
+		const V operands = Ops::set1(static_cast<int32_t>(decoded.operand));
+		for (size_t l = 0; l < s.stride; l += Ops::width) {
+			const V on = Ops::both(Ops::both(Ops::eq(Ops::load(&s.status[l]), active),
+				Ops::eq(Ops::load(&s.instructionCounter[l]), pcs)), Ops::eq(Ops::loadCells(code + l), instructions));
+			Ops::store(&s.mask[l], on);
+			Ops::store(&s.instructionRegister[l], Ops::select(on, instructions, Ops::load(&s.instructionRegister[l])));
+			Ops::store(&s.operationCode[l], Ops::select(on, opCodes, Ops::load(&s.operationCode[l])));
+			Ops::store(&s.operand[l], Ops::select(on, operands, Ops::load(&s.operand[l])));
+		}
+
+		if (decoded.operand >= memorySize) {
+			const V fault = Ops::set1(operandOutOfRange);
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				Ops::store(&s.status[l], Ops::select(Ops::load(&s.mask[l]), fault, Ops::load(&s.status[l])));
+			}
+			continue;
+		}
+
+		const size_t op = decoded.operand;
+		int16_t* cell = &s.cells[op * s.stride];
+
+		switch (decoded.command) {
+
+		case Command::read:
+			// Every lane reads its own input vector, so this one is a gather
+			for (size_t l = 0; l < lanes; ++l) {
+				if (!s.mask[l]) continue;
+				const std::vector<int>& laneInputs = inputs[firstLane + l];
+				if (s.inputIndex[l] >= laneInputs.size()) {
+					s.status[l] = notEnoughInput;
+					continue;
+				}
+				const int word = laneInputs[s.inputIndex[l]];
+				if (!validWord(word)) {
+					s.status[l] = invalidWord;
+					continue;
+				}
+				cell[l] = static_cast<int16_t>(word);
+				++s.inputIndex[l];
+				++s.instructionCounter[l];
+			}
+			break;
+
+		case Command::write:
+			// A mask lane is -1, so subtracting it steps the counter
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				Ops::store(&s.instructionCounter[l], Ops::sub(Ops::load(&s.instructionCounter[l]), Ops::load(&s.mask[l])));
+			}
+			break;
+
+		case Command::load:
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				const V mask = Ops::load(&s.mask[l]);
+				Ops::store(&s.accumulator[l], Ops::select(mask, Ops::loadCells(cell + l), Ops::load(&s.accumulator[l])));
+				Ops::store(&s.instructionCounter[l], Ops::sub(Ops::load(&s.instructionCounter[l]), mask));
+			}
+			break;
+
+		case Command::store:
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				const V mask = Ops::load(&s.mask[l]);
+				Ops::storeCells(cell + l, mask, Ops::load(&s.accumulator[l]));
+				Ops::store(&s.instructionCounter[l], Ops::sub(Ops::load(&s.instructionCounter[l]), mask));
+			}
+			break;
+
+		case Command::add:
+			arithmetic<Ops>(s, cell, additionOutOfRange, [](V a, V b) { return Ops::add(a, b); });
+			break;
+
+		case Command::subtract:
+			arithmetic<Ops>(s, cell, subtractionOutOfRange, [](V a, V b) { return Ops::sub(a, b); });
+			break;
+
+		case Command::multiply:
+			arithmetic<Ops>(s, cell, multiplicationOutOfRange, [](V a, V b) { return Ops::mul(a, b); });
+			break;
+
+		case Command::divide: {
+			const V below = Ops::set1(minWord);
+			const V above = Ops::set1(maxWord);
+			const V byZero = Ops::set1(divisionByZero);
+			const V outOfRange = Ops::set1(divisionOutOfRange);
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				const V mask = Ops::load(&s.mask[l]);
+				const V accumulator = Ops::load(&s.accumulator[l]);
+				const V divisor = Ops::loadCells(cell + l);
+				const V isZero = Ops::eq(divisor, zero);
+				const V word = Ops::div(accumulator, Ops::select(isZero, one, divisor));
+				const V bad = Ops::either(Ops::lt(word, below), Ops::gt(word, above));
+				const V ok = Ops::unless(Ops::either(isZero, bad), mask);
+				const V status = Ops::select(Ops::both(mask, bad), outOfRange, Ops::load(&s.status[l]));
+				Ops::store(&s.status[l], Ops::select(Ops::both(mask, isZero), byZero, status));
+				Ops::store(&s.accumulator[l], Ops::select(ok, word, accumulator));
+				Ops::store(&s.instructionCounter[l], Ops::sub(Ops::load(&s.instructionCounter[l]), ok));
+			}
+			break;
+		}
+
+		case Command::branch: {
+			const V target = Ops::set1(static_cast<int32_t>(op));
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				Ops::store(&s.instructionCounter[l],
+					Ops::select(Ops::load(&s.mask[l]), target, Ops::load(&s.instructionCounter[l])));
+			}
+			break;
+		}
+
+		case Command::branchNeg:
+		case Command::branchZero: {
+			const V target = Ops::set1(static_cast<int32_t>(op));
+			const bool negative = decoded.command == Command::branchNeg;
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				const V accumulator = Ops::load(&s.accumulator[l]);
+				const V counter = Ops::load(&s.instructionCounter[l]);
+				const V jump = negative ? Ops::lt(accumulator, zero) : Ops::eq(accumulator, zero);
+				const V next = Ops::select(jump, target, Ops::add(counter, one));
+				Ops::store(&s.instructionCounter[l], Ops::select(Ops::load(&s.mask[l]), next, counter));
+			}
+			break;
+		}
+
+		case Command::halt:
+		default: {
+			const V done = Ops::set1(halted);
+			for (size_t l = 0; l < s.stride; l += Ops::width) {
+				Ops::store(&s.status[l], Ops::select(Ops::load(&s.mask[l]), done, Ops::load(&s.status[l])));
+			}
+			break;
+		}
+		}
+	}
+}
+
+// An image holding words outside +-9999 does not fit the int16_t lanes; its
+// lanes run one at a time on a full-width machine instead
+void run_scalar(const std::array<int, memorySize>& image, const std::vector<std::vector<int>>& inputs,
+		std::vector<BatchResult>& results) {
+	Computron computron;
+	for (size_t lane = 0; lane < inputs.size(); ++lane) {
+		computron.load(image);
+		computron.setInputs(inputs[lane]);
+		results[lane] = run_to_result(computron);
+	}
+}
+
+} // namespace
+
+std::vector<BatchResult> execute_batch(const std::array<int, memorySize>& image,
+		const std::vector<std::vector<int>>& inputs) {
+
+	std::vector<BatchResult> results(inputs.size());
+	if (find_invalid_word(image.data(), memorySize) != memorySize) {
+		run_scalar(image, inputs, results);
+		return results;
+	}
+
+	Lanes s;
+
+	for (size_t first = 0; first < inputs.size(); first += chunkLanes) {
+		const size_t lanes = std::min(chunkLanes, inputs.size() - first);
+		const size_t stride = (lanes + LaneOps::width - 1) / LaneOps::width * LaneOps::width;
+
+		s.lanes = lanes;
+		s.stride = stride;
+		s.cells.resize(memorySize * stride);
+		for (size_t address = 0; address < memorySize; ++address) {
+			std::fill_n(s.cells.begin() + address * stride, stride, static_cast<int16_t>(image[address]));
+		}
+		s.accumulator.assign(stride, 0);
+		s.instructionCounter.assign(stride, 0);
+		s.instructionRegister.assign(stride, 0);
+		s.operationCode.assign(stride, 0);
+		s.operand.assign(stride, 0);
+		s.status.assign(stride, halted);
+		std::fill_n(s.status.begin(), lanes, running);
+		s.mask.assign(stride, 0);
+		s.inputIndex.assign(stride, 0);
+
+		run_chunk<LaneOps>(s, inputs, first);
+
+		for (size_t l = 0; l < lanes; ++l) {
+			BatchResult& result = results[first + l];
+			for (size_t address = 0; address < memorySize; ++address) {
+				result.memory[address] = s.cells[address * stride + l];
+			}
+			result.accumulator = s.accumulator[l];
+			result.instructionCounter = static_cast<size_t>(s.instructionCounter[l]);
+			result.instructionRegister = s.instructionRegister[l];
+			result.operationCode = static_cast<size_t>(s.operationCode[l]);
+			result.operand = static_cast<size_t>(s.operand[l]);
+			result.halted = s.status[l] == halted;
+			result.error = statusMessage(s.status[l]);
+		}
+	}
+	return results;
+}
@@ -0,0 +1,193 @@
+#include "bundle.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr char bundleMagic[4]{ 'C', 'T', 'R', 'B' };
+
+void put(std::vector<uint8_t>& out, uint64_t value, size_t bytes) {
+	for (size_t i = 0; i < bytes; ++i) {
+		out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+	}
+}
+
+uint64_t get(const uint8_t* data, size_t bytes) {
+	uint64_t value{ 0 };
+	for (size_t i = 0; i < bytes; ++i) {
+		value |= static_cast<uint64_t>(data[i]) << (8 * i);
+	}
+	return value;
+}
+
+// Whether [offset, offset + size) lies in a file of 'fileSize' bytes, without
+// forming a sum a crafted offset could wrap
+bool inFile(uint64_t offset, uint64_t size, uint64_t fileSize) {
+	return offset <= fileSize && size <= fileSize - offset;
+}
+
+#ifdef _WIN32
+// fseek() and ftell() take a long, which is 32 bits on Windows;
+// multi-gigabyte bundles need the 64-bit variants
+int seek(std::FILE* file, uint64_t offset, int origin) {
+	return _fseeki64(file, static_cast<long long>(offset), origin);
+}
+#endif
+
+} // namespace
+
+size_t BundleWriter::add(const std::array<int, memorySize>& memory, size_t count,
+		const std::vector<int>& inputs) {
+	Entry entry;
+	encode_image(memory, count, entry.image);
+	entry.inputs = inputs;
+	entries.push_back(std::move(entry));
+	return entries.size() - 1;
+}
+
+size_t BundleWriter::size() const {
+	return entries.size();
+}
+
+void BundleWriter::save(const std::string& filename) const {
+	std::vector<uint8_t> bytes;
+	bytes.insert(bytes.end(), std::begin(bundleMagic), std::end(bundleMagic));
+	put(bytes, bundleVersion, 2);
+	put(bytes, 0, 2);
+	put(bytes, entries.size(), 4);
+
+	uint64_t offset = bundleHeaderSize + entries.size() * bundleIndexEntrySize;
+	for (const Entry& entry : entries) {
+		put(bytes, offset, 8);
+		put(bytes, entry.image.size(), 4);
+		put(bytes, entry.inputs.size(), 4);
+		offset += entry.image.size() + entry.inputs.size() * sizeof(int32_t);
+	}
+
+	for (const Entry& entry : entries) {
+		bytes.insert(bytes.end(), entry.image.begin(), entry.image.end());
+		for (int value : entry.inputs) {
+			put(bytes, static_cast<uint32_t>(value), 4);
+		}
+	}
+
+	std::FILE* out = std::fopen(filename.c_str(), "wb");
+	if (!out) throw std::runtime_error("Cannot write " + filename);
+	const bool written = std::fwrite(bytes.data(), 1, bytes.size(), out) == bytes.size();
+	if (std::fclose(out) != 0 || !written) throw std::runtime_error("Cannot write " + filename);
+}
+
+BundleReader::BundleReader(const std::string& filename) {
+#ifdef _WIN32
+	file = std::fopen(filename.c_str(), "rb");
+	if (!file) throw std::runtime_error("invalid_input");
+#else
+	fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) throw std::runtime_error("invalid_input");
+#endif
+
+	try {
+#ifdef _WIN32
+		if (seek(file, 0, SEEK_END) != 0) throw std::runtime_error("invalid_input");
+		fileSize = static_cast<uint64_t>(_ftelli64(file));
+#else
+		struct stat status;
+		if (fstat(fd, &status) != 0) throw std::runtime_error("invalid_input");
+		fileSize = static_cast<uint64_t>(status.st_size);
+#endif
+
+		uint8_t header[bundleHeaderSize];
+		read(0, header, sizeof(header));
+		if (std::memcmp(header, bundleMagic, sizeof(bundleMagic)) != 0 ||
+			get(header + 4, 2) != bundleVersion) throw std::runtime_error("invalid_input");
+
+		// The index must fit in the file before anything is sized from its count
+		const size_t count = get(header + 8, 4);
+		if (bundleHeaderSize + uint64_t{ count } * bundleIndexEntrySize > fileSize)
+			throw std::runtime_error("invalid_input");
+		std::vector<uint8_t> raw(count * bundleIndexEntrySize);
+		read(bundleHeaderSize, raw.data(), raw.size());
+
+		index.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			const uint8_t* entry = raw.data() + i * bundleIndexEntrySize;
+			index[i].offset = get(entry, 8);
+			index[i].imageSize = static_cast<uint32_t>(get(entry + 8, 4));
+			index[i].inputCount = static_cast<uint32_t>(get(entry + 12, 4));
+			const uint64_t entrySize = index[i].imageSize + uint64_t{ index[i].inputCount } * sizeof(int32_t);
+			if (!inFile(index[i].offset, entrySize, fileSize)) throw std::runtime_error("invalid_input");
+		}
+	}
+	catch (...) {
+#ifdef _WIN32
+		std::fclose(file);
+#else
+		close(fd);
+#endif
+		throw;
+	}
+}
+
+BundleReader::~BundleReader() {
+#ifdef _WIN32
+	std::fclose(file);
+#else
+	close(fd);
+#endif
+}
+
+size_t BundleReader::size() const {
+	return index.size();
+}
+
+void BundleReader::read(uint64_t offset, void* data, size_t size) const {
+	if (!inFile(offset, size, fileSize)) throw std::runtime_error("invalid_input");
+
+#ifdef _WIN32
+	std::lock_guard<std::mutex> lock(mutex);
+	if (seek(file, offset, SEEK_SET) != 0 ||
+		std::fread(data, 1, size, file) != size) throw std::runtime_error("invalid_input");
+#else
+	// pread() leaves the descriptor's position alone, so readers need no lock
+	uint8_t* out = static_cast<uint8_t*>(data);
+	while (size > 0) {
+		const ssize_t got = pread(fd, out, size, static_cast<off_t>(offset));
+		if (got < 0 && errno == EINTR) continue;
+		if (got <= 0) throw std::runtime_error("invalid_input");
+		out += got;
+		offset += static_cast<uint64_t>(got);
+		size -= static_cast<size_t>(got);
+	}
+#endif
+}
+
+size_t BundleReader::load(size_t n, std::array<int, memorySize>& memory) const {
+	if (n >= index.size()) throw std::runtime_error("invalid_input");
+
+	std::array<uint8_t, imageHeaderSize + memorySize * sizeof(int16_t)> bytes;
+	if (index[n].imageSize > bytes.size()) throw std::runtime_error("invalid_input");
+	read(index[n].offset, bytes.data(), index[n].imageSize);
+	return decode_image(bytes.data(), index[n].imageSize, memory);
+}
+
+std::vector<int> BundleReader::inputs(size_t n) const {
+	if (n >= index.size()) throw std::runtime_error("invalid_input");
+
+	std::vector<uint8_t> raw(index[n].inputCount * sizeof(int32_t));
+	read(index[n].offset + index[n].imageSize, raw.data(), raw.size());
+
+	std::vector<int> values(index[n].inputCount);
+	for (size_t i = 0; i < values.size(); ++i) {
+		values[i] = static_cast<int32_t>(static_cast<uint32_t>(get(raw.data() + i * sizeof(int32_t), 4)));
+	}
+	return values;
+}
@@ -0,0 +1,89 @@
+#include "cache.h"
+
+#include <cstdio>
+#include <functional>
+#include <stdexcept>
+
+CachedProgram::CachedProgram(std::string text, const std::array<int, memorySize>& memory, size_t count)
+	: text{ std::move(text) }, memory{ memory }, count{ count } {
+	fuse_program(memory, fused);
+}
+
+const std::string& CachedProgram::getText() const {
+	return text;
+}
+
+const std::array<int, memorySize>& CachedProgram::getMemory() const {
+	return memory;
+}
+
+size_t CachedProgram::getCount() const {
+	return count;
+}
+
+const FusedProgram& CachedProgram::getFused() const {
+	return fused;
+}
+
+const JitProgram& CachedProgram::getCompiled() const {
+	std::call_once(compileOnce, [this]() { compiled = std::make_unique<JitProgram>(memory, 0); });
+	return *compiled;
+}
+
+std::shared_ptr<const CachedProgram> ProgramCache::load(const std::string& filename) {
+	std::FILE* file = std::fopen(filename.c_str(), "rb");
+	if (!file) throw std::runtime_error("invalid_input");
+
+	std::string text;
+	char chunk[4096];
+	for (size_t got; (got = std::fread(chunk, 1, sizeof(chunk), file)) > 0;) {
+		text.append(chunk, got);
+	}
+	std::fclose(file);
+
+	return parse(text);
+}
+
+std::shared_ptr<const CachedProgram> ProgramCache::parse(std::string_view text) {
+	const size_t hash = std::hash<std::string_view>{}(text);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		const auto [first, last] = programs.equal_range(hash);
+		for (auto it = first; it != last; ++it) {
+			if (it->second->getText() == text) {
+				++hits;
+				return it->second;
+			}
+		}
+	}
+
+	// Parse outside the lock; if another thread raced us here, keep its entry
+	std::array<int, memorySize> memory{ 0 };
+	const size_t count = parse_program(text, memory);
+	auto program = std::make_shared<const CachedProgram>(std::string(text), memory, count);
+
+	std::lock_guard<std::mutex> lock(mutex);
+	const auto [first, last] = programs.equal_range(hash);
+	for (auto it = first; it != last; ++it) {
+		if (it->second->getText() == text) return it->second;
+	}
+	programs.emplace(hash, program);
+	return program;
+}
+
+size_t ProgramCache::size() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return programs.size();
+}
+
+size_t ProgramCache::getHits() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return hits;
+}
+
+void ProgramCache::clear() {
+	std::lock_guard<std::mutex> lock(mutex);
+	programs.clear();
+	hits = 0;
+}
@@ -1,10 +1,32 @@
 #include "computron.h"
+#include "computron_impl.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <cstdio>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <stdexcept>
 #include <cstdlib>
 #include <sstream>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+#include <io.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
 
 Command opCodeToCommand(size_t opCode) {
 	switch (opCode) {
@@ -31,67 +53,175 @@ Command opCodeToCommand(size_t opCode) {
 	}
 }
 
-void load_from_file(std::array<int, memorySize>& memory, const std::string& filename) {
+// Parses one line the way std::stoi would: leading whitespace, an optional
+// sign, digits, and anything after the digits ignored
+static int parse_word(const char* begin, const char* end) {
+	while (begin < end && (*begin == ' ' || *begin == '\t' || *begin == '\r' ||
+		*begin == '\v' || *begin == '\f')) ++begin;
+	if (begin < end && *begin == '+' && begin + 1 < end && *(begin + 1) != '-') ++begin;
+
+	int value{ 0 };
+	const auto [next, error] = std::from_chars(begin, end, value);
+	if (error != std::errc{} || next == begin) throw std::runtime_error("invalid_input");
+	return value;
+}
+
+// Stores the word on one line at memory[i++]; false if it was the sentinel.
+// The sentinel is reserved at every memory size, so machines large enough for
+// -99999 to be a valid word cannot load it from text.
+template <typename Word, size_t Cells>
+static bool load_line(const char* begin, const char* end, std::array<Word, Cells>& memory, size_t& i) {
 	constexpr int sentinel{ -99999 }; // terminates reading after -99999
+	const int instruction = parse_word(begin, end);
+
+	if (instruction == sentinel) return false;
+
+	// Check if the instruction is valid using the validWord function
+	// If the instruction is valid, store it in memory at position 'i' and increment 'i'
+	// If the instruction is invalid, throw a runtime error with message "invalid_input"
+	if (!MachineConfig<Cells>::validWord(instruction)) throw std::runtime_error("invalid_input");
+	if (i >= Cells) throw std::runtime_error("invalid_input");
+	memory[i++] = static_cast<Word>(instruction);
+	return true;
+}
+
+template <typename Word, size_t Cells>
+static size_t parse_words(std::string_view text, std::array<Word, Cells>& memory) {
 	size_t i{ 0 };
-	std::string line;
-	int instruction;
+	const char* position = text.data();
+	const char* const end = position + text.size();
+
+	while (position < end) {
+		const char* lineEnd = static_cast<const char*>(std::memchr(position, '\n', end - position));
+		if (!lineEnd) lineEnd = end;
+
+		if (!load_line(position, lineEnd, memory, i)) break;
+		position = lineEnd == end ? end : lineEnd + 1;
+	}
+	return i;
+}
+
+size_t parse_program(std::string_view text, std::array<int, memorySize>& memory) {
+	return parse_words(text, memory);
+}
 
-	std::ifstream inputFile(filename);
+template <typename Word, size_t Cells>
+size_t load_from_file(std::array<Word, Cells>& memory, const std::string& filename) {
+	// One unbuffered read into a per-thread buffer that keeps its capacity
+	// between files, then parse in place
+	thread_local std::string buffer;
+
+	std::FILE* inputFile = std::fopen(filename.c_str(), "rb");
 	if (!inputFile)
 		// throw runtime_error exception with string "invalid_input"
 		throw std::runtime_error("invalid_input");
+	std::setvbuf(inputFile, nullptr, _IONBF, 0);
 
+	size_t length{ 0 };
+	buffer.resize(std::max<size_t>(buffer.capacity(), 4096));
+	for (;;) {
+		length += std::fread(&buffer[length], 1, buffer.size() - length, inputFile);
+		if (length < buffer.size()) break;
+		buffer.resize(buffer.size() * 2);
+	}
+	std::fclose(inputFile);
 
-	while (std::getline(inputFile, line)) {
-		instruction = std::stoi(line);
+	return parse_words(std::string_view(buffer.data(), length), memory);
+}
 
-		if (instruction == sentinel) break;
+template size_t load_from_file(std::array<int, memorySize>& memory, const std::string& filename);
+template size_t load_from_file(std::array<int16_t, memorySize>& memory, const std::string& filename);
+template size_t load_from_file(std::array<int, 1000>& memory, const std::string& filename);
+template size_t load_from_file(std::array<int, 10000>& memory, const std::string& filename);
 
-		/*int absVal = (instruction >= 0) ? instruction : -instruction;
+size_t load_from_stream(std::array<int, memorySize>& memory, std::istream& in) {
+	thread_local std::string line;
+	size_t i{ 0 };
 
-		// Count number of digits
-		int digits = 0;
-		if (absVal == 0) {
-			digits = 1;
-		}
-		else {
-			int temp = absVal;
-			while (temp > 0) {
-				temp /= 10;
-				digits++;
-			}
-		}
+	while (std::getline(in, line)) {
+		if (!load_line(line.data(), line.data() + line.size(), memory, i)) break;
+	}
+	if (in.bad()) throw std::runtime_error("invalid_input");
+	return i;
+}
 
-		// Now pad if it's 13 digits (and within valid opcode range)
-		if (digits == 2) {
-			instruction *= 100;
-		}
-		else if (digits == 3) {
-			instruction *= 10;
-		}
-		else if (digits == 1) {
-			throw std::runtime_error("invalid_input");
-		}
-		else if (digits > 4) {
-			throw std::runtime_error("invalid_input");
+size_t load_from_fd(std::array<int, memorySize>& memory, int fd) {
+	// One byte per read() so nothing past the sentinel line leaves the descriptor;
+	// a whole program is only a few hundred bytes
+	thread_local std::string line;
+	size_t i{ 0 };
+
+	for (;;) {
+		line.clear();
+		char c{ 0 };
+		long got{ 0 };
+		for (;;) {
+#ifdef _WIN32
+			got = _read(fd, &c, 1);
+#else
+			got = ::read(fd, &c, 1);
+			if (got < 0 && errno == EINTR) continue;
+#endif
+			if (got <= 0 || c == '\n') break;
+			line.push_back(c);
 		}
-		*/
-		// Check if the instruction is valid using the validWord function
-		// If the instruction is valid, store it in memory at position 'i' and increment 'i'
-		// If the instruction is invalid, throw a runtime error with message "invalid_input"
-		if (!validWord(instruction)) throw std::runtime_error("invalid_input");
-		if (i >= memorySize) throw std::runtime_error("invalid_input");
-		memory[i++] = instruction;
+		if (got < 0) throw std::runtime_error("invalid_input");
+
+		// End of input: the last line may have no newline
+		if (got == 0 && line.empty()) break;
+		if (!load_line(line.data(), line.data() + line.size(), memory, i)) break;
+		if (got == 0) break;
 	}
-	inputFile.close();
+	return i;
 }
 
-void execute(std::array<int, memorySize>& memory, int* const acPtr,
+size_t load_from_mapped_file(std::array<int, memorySize>& memory, const std::string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+	const int fd = open(filename.c_str(), O_RDONLY);
+	if (fd < 0) throw std::runtime_error("invalid_input");
+
+	struct stat status;
+	if (fstat(fd, &status) != 0) {
+		close(fd);
+		throw std::runtime_error("invalid_input");
+	}
+
+	const size_t length = static_cast<size_t>(status.st_size);
+	if (length == 0) {
+		close(fd);
+		return 0;
+	}
+
+	// The mapping stays valid after the descriptor is closed
+	void* mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (mapped == MAP_FAILED) throw std::runtime_error("invalid_input");
+
+	try {
+		const size_t loaded = parse_program(std::string_view(static_cast<const char*>(mapped), length), memory);
+		munmap(mapped, length);
+		return loaded;
+	}
+	catch (...) {
+		munmap(mapped, length);
+		throw;
+	}
+#else
+	return load_from_file(memory, filename);
+#endif
+}
+
+template <typename Word, size_t Cells>
+void execute(std::array<Word, Cells>& memory, int* const acPtr,
 			size_t* const icPtr, int* const irPtr,
 			size_t* const opCodePtr, size_t* const opPtr,
 			const std::vector<int>& inputs) {
 
+	// The operand base is a constant for each size, so the decode below
+	// compiles to the multiply-and-shift sequences of a fixed divisor
+	using Config = MachineConfig<Cells>;
+	using Arithmetic = typename Config::Arithmetic;
+
 	size_t inputIndex{ 0 }; // Tracks input
 
 	do {
@@ -101,28 +231,28 @@ void execute(std::array<int, memorySize>& memory, int* const acPtr,
 		// operand = instructionRegister % 100; // remainder
 
 		// Fetch instruction from memory and store in the instructionRegister
-		if (*icPtr >= memorySize) throw std::runtime_error("Instruction counter out of range");
+		if (*icPtr >= Cells) throw std::runtime_error("Instruction counter out of range");
 		*irPtr = memory[*icPtr];
 
 		// Decode the instruction
-		*opCodePtr = static_cast<size_t>((*irPtr) / 100);
-		*opPtr = static_cast<size_t>((*irPtr) % 100);
+		*opCodePtr = static_cast<size_t>((*irPtr) / Config::operandBase);
+		*opPtr = static_cast<size_t>((*irPtr) % Config::operandBase);
 
 		// Check if operand is in the valid range
-		if (*opPtr >= memorySize) throw std::runtime_error("Operand out of range");
+		if (*opPtr >= Cells) throw std::runtime_error("Operand out of range");
 
 		// Execute
-		switch (int word{}; opCodeToCommand(*opCodePtr)) {
+		switch (Arithmetic word{}; opCodeToCommand(*opCodePtr)) {
 
 		case Command::read:
 			if (inputIndex >= inputs.size()) throw std::runtime_error("Not enough input values");
 
 			word = inputs[inputIndex];
 
-			if (!validWord(word)) throw std::runtime_error("Invalid word");
+			if (!Config::validWord(word)) throw std::runtime_error("Invalid word");
 
 			// Assign the value of 'word' to the memory location pointed to by 'opPtr'
-			memory[*opPtr] = word;
+			memory[*opPtr] = static_cast<Word>(word);
 			// Increment the instruction counter (icPtr) to point to the next instruction
 			++(*icPtr);
 			inputIndex++;
@@ -146,7 +276,7 @@ void execute(std::array<int, memorySize>& memory, int* const acPtr,
 		case Command::store:
 			// Store the value in the accumulator (acPtr) into the memory location pointed to by 'opPtr'
 			// Increment the instruction counter (icPtr) to move to the next instruction
-			memory[*opPtr] = *acPtr;
+			memory[*opPtr] = static_cast<Word>(*acPtr);
 			++(*icPtr);
 			break;
 
@@ -155,9 +285,9 @@ void execute(std::array<int, memorySize>& memory, int* const acPtr,
 			// by 'opPtr' and store the result in 'word'
 			// If the result is valid, store it in the accumulator and increment the instruction counter
 			// / If the result is invalid, throw a runtime error
-			word = *acPtr + memory[*opPtr];
-			if (!validWord(word)) throw std::runtime_error("Addition out of range");
-			*acPtr = word;
+			word = static_cast<Arithmetic>(*acPtr) + memory[*opPtr];
+			if (!Config::validWord(word)) throw std::runtime_error("Addition out of range");
+			*acPtr = static_cast<int>(word);
 			++(*icPtr);
 			break;
 
@@ -166,26 +296,26 @@ void execute(std::array<int, memorySize>& memory, int* const acPtr,
 			// accumulator (acPtr) and store the result in 'word'
 			// If the result is valid, store it in the accumulator and increment the instruction counter
 			// / If the result is invalid, throw a runtime error
-			word = *acPtr - memory[*opPtr];
-			if (!validWord(word)) throw std::runtime_error("Subtraction out of range");
-			*acPtr = word;
+			word = static_cast<Arithmetic>(*acPtr) - memory[*opPtr];
+			if (!Config::validWord(word)) throw std::runtime_error("Subtraction out of range");
+			*acPtr = static_cast<int>(word);
 			++(*icPtr);
 			break;
 
 		case Command::multiply:
 			// as above do it for multiplication
-			word = *acPtr * memory[*opPtr];
-			if (!validWord(word)) throw std::runtime_error("Multiplication out of range");
-			*acPtr = word;
+			word = static_cast<Arithmetic>(*acPtr) * memory[*opPtr];
+			if (!Config::validWord(word)) throw std::runtime_error("Multiplication out of range");
+			*acPtr = static_cast<int>(word);
 			++(*icPtr);
 			break;
 
 		case Command::divide:
 			// as above do it for division
 			if (memory[*opPtr] == 0) throw std::runtime_error("Division by 0");
-			word = *acPtr / memory[*opPtr];
-			if (!validWord(word)) throw std::runtime_error("Division out of range");
-			*acPtr = word;
+			word = static_cast<Arithmetic>(*acPtr) / memory[*opPtr];
+			if (!Config::validWord(word)) throw std::runtime_error("Division out of range");
+			*acPtr = static_cast<int>(word);
 			++(*icPtr);
 			break;
 
@@ -211,11 +341,649 @@ void execute(std::array<int, memorySize>& memory, int* const acPtr,
 	} while (opCodeToCommand(*opCodePtr) != Command::halt);
 }
 
+template void execute(std::array<int, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr, size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+template void execute(std::array<int16_t, memorySize>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr, size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+template void execute(std::array<int, 1000>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr, size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+template void execute(std::array<int, 10000>& memory, int* const acPtr,
+	size_t* const icPtr, int* const irPtr, size_t* const opCodePtr, size_t* const opPtr,
+	const std::vector<int>& inputs);
+
+// decode() for a machine of any size
+template <typename Config>
+static DecodedInstruction decode_as(int instruction) {
+	DecodedInstruction decoded;
+	decoded.instruction = instruction;
+	decoded.operationCode = static_cast<size_t>(instruction / Config::operandBase);
+	decoded.operand = static_cast<size_t>(instruction % Config::operandBase);
+	decoded.command = opCodeToCommand(decoded.operationCode);
+	return decoded;
+}
+
+DecodedInstruction decode(int instruction) {
+	return decode_as<StandardConfig>(instruction);
+}
+
+void decode_program(const std::array<int, memorySize>& memory, DecodedProgram& program) {
+	for (size_t i = 0; i < memorySize; ++i) {
+		program[i] = decode(memory[i]);
+	}
+}
+
+template <size_t Cells>
+std::array<bool, Cells> reachable_cells(const std::array<int, Cells>& memory, size_t entry) {
+	std::array<bool, Cells> isCode{};
+	std::vector<size_t> pending{ entry };
+
+	while (!pending.empty()) {
+		const size_t address = pending.back();
+		pending.pop_back();
+		if (address >= Cells || isCode[address]) continue;
+		isCode[address] = true;
+
+		// Faulting instructions and halts end the path
+		const DecodedInstruction decoded = decode_as<MachineConfig<Cells>>(memory[address]);
+		if (decoded.operand >= Cells) continue;
+
+		switch (decoded.command) {
+		case Command::halt:
+			break;
+		case Command::branch:
+			pending.push_back(decoded.operand);
+			break;
+		case Command::branchNeg:
+		case Command::branchZero:
+			pending.push_back(decoded.operand);
+			pending.push_back(address + 1);
+			break;
+		default:
+			pending.push_back(address + 1);
+			break;
+		}
+	}
+	return isCode;
+}
+
+template std::array<bool, memorySize> reachable_cells(const std::array<int, memorySize>& memory, size_t entry);
+template std::array<bool, 1000> reachable_cells(const std::array<int, 1000>& memory, size_t entry);
+template std::array<bool, 10000> reachable_cells(const std::array<int, 10000>& memory, size_t entry);
+
+// Executes 'current', the decoded instruction at *icPtr, and returns its
+// command. onWrite(address, word) runs after every write into memory so the
+// caller can drop whatever it derived from that cell. Shared by the decoded,
+// fused and block-cached modes.
+template <typename OnWrite>
+static Command step_instruction(const DecodedInstruction& current, std::array<int, memorySize>& memory,
+			int* const acPtr, size_t* const icPtr, int* const irPtr,
+			size_t* const opCodePtr, size_t* const opPtr,
+			const std::vector<int>& inputs, size_t& inputIndex, OnWrite onWrite) {
+
+	*irPtr = current.instruction;
+	*opCodePtr = current.operationCode;
+	*opPtr = current.operand;
+	const Command command = current.command;
+
+	if (*opPtr >= memorySize) throw std::runtime_error("Operand out of range");
+
+	switch (int word{}; command) {
+
+	case Command::read:
+		if (inputIndex >= inputs.size()) throw std::runtime_error("Not enough input values");
+		word = inputs[inputIndex];
+		if (!validWord(word)) throw std::runtime_error("Invalid word");
+		memory[*opPtr] = word;
+		onWrite(*opPtr, word);
+		++(*icPtr);
+		inputIndex++;
+		break;
+
+	case Command::write:
+		++(*icPtr);
+		break;
+
+	case Command::load:
+		*acPtr = memory[*opPtr];
+		++(*icPtr);
+		break;
+
+	case Command::store:
+		memory[*opPtr] = *acPtr;
+		onWrite(*opPtr, *acPtr);
+		++(*icPtr);
+		break;
+
+	case Command::add:
+		word = *acPtr + memory[*opPtr];
+		if (!validWord(word)) throw std::runtime_error("Addition out of range");
+		*acPtr = word;
+		++(*icPtr);
+		break;
+
+	case Command::subtract:
+		word = *acPtr - memory[*opPtr];
+		if (!validWord(word)) throw std::runtime_error("Subtraction out of range");
+		*acPtr = word;
+		++(*icPtr);
+		break;
+
+	case Command::multiply:
+		word = *acPtr * memory[*opPtr];
+		if (!validWord(word)) throw std::runtime_error("Multiplication out of range");
+		*acPtr = word;
+		++(*icPtr);
+		break;
+
+	case Command::divide:
+		if (memory[*opPtr] == 0) throw std::runtime_error("Division by 0");
+		word = *acPtr / memory[*opPtr];
+		if (!validWord(word)) throw std::runtime_error("Division out of range");
+		*acPtr = word;
+		++(*icPtr);
+		break;
+
+	case Command::branch:
+		*icPtr = *opPtr;
+		break;
+
+	case Command::branchNeg:
+		*acPtr < 0 ? *icPtr = *opPtr : ++(*icPtr);
+		break;
+
+	case Command::branchZero:
+		*acPtr == 0 ? *icPtr = *opPtr : ++(*icPtr);
+		break;
+
+	case Command::halt:
+		break;
+
+	default:
+		break;
+	}
+	return command;
+}
+
+static Command step_decoded(std::array<int, memorySize>& memory, DecodedProgram& program,
+			int* const acPtr, size_t* const icPtr, int* const irPtr,
+			size_t* const opCodePtr, size_t* const opPtr,
+			const std::vector<int>& inputs, size_t& inputIndex) {
+
+	if (*icPtr >= memorySize) throw std::runtime_error("Instruction counter out of range");
+	return step_instruction(program[*icPtr], memory, acPtr, icPtr, irPtr, opCodePtr, opPtr,
+		inputs, inputIndex, [&program](size_t address, int word) { program[address] = decode(word); });
+}
+
+template <size_t Cells>
+bool verify_program(const std::array<int, Cells>& memory, size_t entry) {
+	if (entry >= Cells) return false;
+
+	const std::array<bool, Cells> isCode = reachable_cells(memory, entry);
+
+	for (size_t address = 0; address < Cells; ++address) {
+		if (!isCode[address]) continue;
+
+		const DecodedInstruction decoded = decode_as<MachineConfig<Cells>>(memory[address]);
+
+		// Known opcode: opCodeToCommand() maps everything else to halt
+		if (decoded.instruction < 0 || static_cast<size_t>(decoded.command) != decoded.operationCode) return false;
+		if (decoded.operand >= Cells) return false;
+
+		switch (decoded.command) {
+		case Command::read:
+		case Command::store:
+			// A write into code could replace an instruction with anything
+			if (isCode[decoded.operand]) return false;
+			[[fallthrough]];
+		default:
+			// Falls through to the next cell, which must exist
+			if (address + 1 >= Cells) return false;
+			break;
+		case Command::branch:
+		case Command::halt:
+			break;
+		}
+	}
+	return true;
+}
+
+template bool verify_program(const std::array<int, memorySize>& memory, size_t entry);
+template bool verify_program(const std::array<int, 1000>& memory, size_t entry);
+template bool verify_program(const std::array<int, 10000>& memory, size_t entry);
+
+void execute_decoded(std::array<int, memorySize>& memory, DecodedProgram& program,
+			int* const acPtr, size_t* const icPtr, int* const irPtr,
+			size_t* const opCodePtr, size_t* const opPtr,
+			const std::vector<int>& inputs) {
+
+	// Same semantics as execute(), but fetch/decode is done once per cell by
+	// decode_program(). Every write into memory re-decodes the written cell so
+	// self-modifying programs still execute what they stored.
+	size_t inputIndex{ 0 };
+	Command command;
+
+	do {
+		command = step_decoded(memory, program, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs, inputIndex);
+	} while (command != Command::halt);
+}
+
+// Recognizes the superinstruction starting at 'address', if any
+static Superinstruction fuse_at(const DecodedProgram& decoded, size_t address) {
+	auto is = [&decoded](size_t at, Command command) {
+		return at < memorySize && decoded[at].command == command && decoded[at].operand < memorySize;
+	};
+
+	if (!is(address, Command::load)) return Superinstruction::none;
+	if (is(address + 1, Command::add) && is(address + 2, Command::store))
+		return Superinstruction::loadAddStore;
+	if (is(address + 1, Command::subtract) && is(address + 2, Command::branchZero))
+		return Superinstruction::loadSubtractBranchZero;
+	if (is(address + 1, Command::branchNeg))
+		return Superinstruction::loadBranchNeg;
+	return Superinstruction::none;
+}
+
+// A write into 'address' can change the superinstructions that cover it
+static void refuse(FusedProgram& program, size_t address) {
+	const size_t first = address >= 2 ? address - 2 : 0;
+	for (size_t i = first; i <= address; ++i) {
+		program.fused[i] = fuse_at(program.decoded, i);
+	}
+}
+
+void fuse_program(const std::array<int, memorySize>& memory, FusedProgram& program) {
+	decode_program(memory, program.decoded);
+	for (size_t i = 0; i < memorySize; ++i) {
+		program.fused[i] = fuse_at(program.decoded, i);
+	}
+}
+
+void execute_fused(std::array<int, memorySize>& memory, FusedProgram& program,
+			int* const acPtr, size_t* const icPtr, int* const irPtr,
+			size_t* const opCodePtr, size_t* const opPtr,
+			const std::vector<int>& inputs) {
+
+	// Registers only become visible when the run ends, so a superinstruction
+	// publishes the instruction it stopped on: the last one, or the one that faulted
+	auto publish = [&](size_t address) {
+		const DecodedInstruction& at = program.decoded[address];
+		*icPtr = address;
+		*irPtr = at.instruction;
+		*opCodePtr = at.operationCode;
+		*opPtr = at.operand;
+	};
+
+	size_t inputIndex{ 0 };
+	Command command{ Command::halt };
+
+	do {
+		const size_t ic = *icPtr;
+		const Superinstruction fused = ic < memorySize ? program.fused[ic] : Superinstruction::none;
+
+		switch (int word{}; fused) {
+
+		case Superinstruction::loadAddStore: {
+			// load X; add Y; store Z
+			const DecodedProgram& d = program.decoded;
+			const size_t store = d[ic + 2].operand;
+			word = memory[d[ic].operand] + memory[d[ic + 1].operand];
+			if (!validWord(word)) {
+				*acPtr = memory[d[ic].operand];
+				publish(ic + 1);
+				throw std::runtime_error("Addition out of range");
+			}
+			*acPtr = word;
+			memory[store] = word;
+			publish(ic + 2);
+			*icPtr = ic + 3;
+			program.decoded[store] = decode(word);
+			refuse(program, store);
+			command = Command::store;
+			break;
+		}
+
+		case Superinstruction::loadSubtractBranchZero: {
+			// load X; subtract Y; branchZero T
+			const DecodedProgram& d = program.decoded;
+			word = memory[d[ic].operand] - memory[d[ic + 1].operand];
+			if (!validWord(word)) {
+				*acPtr = memory[d[ic].operand];
+				publish(ic + 1);
+				throw std::runtime_error("Subtraction out of range");
+			}
+			*acPtr = word;
+			publish(ic + 2);
+			*icPtr = word == 0 ? d[ic + 2].operand : ic + 3;
+			command = Command::branchZero;
+			break;
+		}
+
+		case Superinstruction::loadBranchNeg: {
+			// load X; branchNeg T
+			const DecodedProgram& d = program.decoded;
+			*acPtr = memory[d[ic].operand];
+			publish(ic + 1);
+			*icPtr = *acPtr < 0 ? d[ic + 1].operand : ic + 2;
+			command = Command::branchNeg;
+			break;
+		}
+
+		case Superinstruction::none:
+		default:
+			command = step_decoded(memory, program.decoded, acPtr, icPtr, irPtr,
+				opCodePtr, opPtr, inputs, inputIndex);
+			if (command == Command::read || command == Command::store) refuse(program, *opPtr);
+			break;
+		}
+	} while (command != Command::halt);
+}
+
+const BasicBlock& BlockCache::lookup(const std::array<int, memorySize>& memory, size_t address) {
+	if (blocks[address]) {
+		// The block may come from another image, e.g. a run that patched this
+		// code; any cell whose word changed drops the blocks built from it
+		const std::vector<DecodedInstruction>& instructions = blocks[address]->instructions;
+		size_t changed = memorySize;
+		for (size_t i = 0; i < instructions.size(); ++i) {
+			if (memory[address + i] != instructions[i].instruction) {
+				changed = address + i;
+				break;
+			}
+		}
+		if (changed == memorySize) return *blocks[address];
+		invalidate(changed);
+	}
+
+	// Translate up to and including the first branch, halt or faulting instruction
+	auto block = std::make_unique<BasicBlock>();
+	block->start = address;
+	for (size_t i = address; i < memorySize; ++i) {
+		const DecodedInstruction decoded = decode(memory[i]);
+		block->instructions.push_back(decoded);
+		owners[i].push_back(address);
+
+		if (decoded.operand >= memorySize || decoded.command == Command::branch ||
+			decoded.command == Command::branchNeg || decoded.command == Command::branchZero ||
+			decoded.command == Command::halt) break;
+	}
+
+	blocks[address] = std::move(block);
+	return *blocks[address];
+}
+
+void BlockCache::invalidate(size_t address) {
+	// Only the blocks translated from this cell go; data writes cost one empty check
+	std::vector<size_t> stale;
+	stale.swap(owners[address]);
+
+	for (size_t start : stale) {
+		if (!blocks[start]) continue;
+		const size_t end = start + blocks[start]->instructions.size();
+		for (size_t i = start; i < end; ++i) {
+			if (i == address) continue;
+			auto& cellOwners = owners[i];
+			cellOwners.erase(std::remove(cellOwners.begin(), cellOwners.end(), start), cellOwners.end());
+		}
+		blocks[start].reset();
+	}
+}
+
+bool BlockCache::cached(size_t address) const {
+	return address < memorySize && blocks[address] != nullptr;
+}
+
+size_t BlockCache::size() const {
+	return static_cast<size_t>(std::count_if(blocks.begin(), blocks.end(),
+		[](const std::unique_ptr<BasicBlock>& block) { return block != nullptr; }));
+}
+
+void execute_cached(std::array<int, memorySize>& memory, BlockCache& cache,
+			int* const acPtr, size_t* const icPtr, int* const irPtr,
+			size_t* const opCodePtr, size_t* const opPtr,
+			const std::vector<int>& inputs) {
+
+	size_t inputIndex{ 0 };
+	Command command{ Command::halt };
+
+	do {
+		if (*icPtr >= memorySize) throw std::runtime_error("Instruction counter out of range");
+
+		const size_t start = *icPtr;
+		const BasicBlock& block = cache.lookup(memory, start);
+		bool valid = true;
+
+		// Every instruction but the last falls through, so the block runs in order
+		// until it ends or a write invalidates it under our feet
+		for (size_t i = 0; valid && i < block.instructions.size(); ++i) {
+			command = step_instruction(block.instructions[i], memory, acPtr, icPtr, irPtr,
+				opCodePtr, opPtr, inputs, inputIndex, [&](size_t address, int) {
+					cache.invalidate(address);
+					valid = cache.cached(start);
+				});
+		}
+	} while (command != Command::halt);
+}
+
+void run_compiled(void (*function)(CompiledContext*),
+		std::array<int, memorySize>& memory, int* const acPtr,
+		size_t* const icPtr, int* const irPtr,
+		size_t* const opCodePtr, size_t* const opPtr,
+		const std::vector<int>& inputs) {
+
+	CompiledContext context;
+	context.memory = memory.data();
+	context.inputs = inputs.data();
+	context.inputCount = inputs.size();
+	context.instructionCounter = *icPtr;
+	context.accumulator = *acPtr;
+
+	function(&context);
+
+	*acPtr = context.accumulator;
+	*icPtr = context.instructionCounter;
+
+	// Falling off the end can only come from the last cell
+	if (*icPtr == memorySize) {
+		const DecodedInstruction last = decode(memory[memorySize - 1]);
+		*irPtr = last.instruction;
+		*opCodePtr = last.operationCode;
+		*opPtr = last.operand;
+	}
+
+	// The interpreter executes the instruction at the exit (halting, faulting
+	// or self-modifying) and the rest
+	const std::vector<int> remaining(inputs.begin() + context.inputIndex, inputs.end());
+	execute(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, remaining);
+}
+
+// Dense handler slot for a command: (opCode / 10 - 1) * 4 + opCode % 10,
+// so read..halt land in 0..15 and the unused slots fall through to halt
+static size_t commandSlot(Command command) {
+	const size_t opCode = static_cast<size_t>(command);
+	return (opCode / 10 - 1) * 4 + opCode % 10;
+}
+
+void execute_threaded(std::array<int, memorySize>& memory, int* const acPtr,
+			size_t* const icPtr, int* const irPtr,
+			size_t* const opCodePtr, size_t* const opPtr,
+			const std::vector<int>& inputs) {
+
+	DecodedProgram program;
+	decode_program(memory, program);
+
+#if defined(__GNUC__) || defined(__clang__)
+	// Direct threading: every handler ends by jumping straight to the handler of
+	// the next instruction, so each opcode gets its own indirect branch instead of
+	// all of them sharing the one at the top of a switch.
+	static void* const handlers[16] = {
+		&&do_read, &&do_write, &&do_halt, &&do_halt,
+		&&do_load, &&do_store, &&do_halt, &&do_halt,
+		&&do_add, &&do_subtract, &&do_divide, &&do_multiply,
+		&&do_branch, &&do_branchNeg, &&do_branchZero, &&do_halt
+	};
+
+	size_t inputIndex{ 0 };
+	int word{ 0 };
+
+#define COMPUTRON_DISPATCH() \
+	do { \
+		if (*icPtr >= memorySize) throw std::runtime_error("Instruction counter out of range"); \
+		const DecodedInstruction& next = program[*icPtr]; \
+		*irPtr = next.instruction; \
+		*opCodePtr = next.operationCode; \
+		*opPtr = next.operand; \
+		if (*opPtr >= memorySize) throw std::runtime_error("Operand out of range"); \
+		goto *handlers[commandSlot(next.command)]; \
+	} while (false)
+
+	COMPUTRON_DISPATCH();
+
+do_read:
+	if (inputIndex >= inputs.size()) throw std::runtime_error("Not enough input values");
+	word = inputs[inputIndex];
+	if (!validWord(word)) throw std::runtime_error("Invalid word");
+	memory[*opPtr] = word;
+	program[*opPtr] = decode(word);
+	++(*icPtr);
+	inputIndex++;
+	COMPUTRON_DISPATCH();
+
+do_write:
+	++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_load:
+	*acPtr = memory[*opPtr];
+	++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_store:
+	memory[*opPtr] = *acPtr;
+	program[*opPtr] = decode(*acPtr);
+	++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_add:
+	word = *acPtr + memory[*opPtr];
+	if (!validWord(word)) throw std::runtime_error("Addition out of range");
+	*acPtr = word;
+	++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_subtract:
+	word = *acPtr - memory[*opPtr];
+	if (!validWord(word)) throw std::runtime_error("Subtraction out of range");
+	*acPtr = word;
+	++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_multiply:
+	word = *acPtr * memory[*opPtr];
+	if (!validWord(word)) throw std::runtime_error("Multiplication out of range");
+	*acPtr = word;
+	++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_divide:
+	if (memory[*opPtr] == 0) throw std::runtime_error("Division by 0");
+	word = *acPtr / memory[*opPtr];
+	if (!validWord(word)) throw std::runtime_error("Division out of range");
+	*acPtr = word;
+	++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_branch:
+	*icPtr = *opPtr;
+	COMPUTRON_DISPATCH();
+
+do_branchNeg:
+	*acPtr < 0 ? *icPtr = *opPtr : ++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_branchZero:
+	*acPtr == 0 ? *icPtr = *opPtr : ++(*icPtr);
+	COMPUTRON_DISPATCH();
+
+do_halt:
+	return;
+
+#undef COMPUTRON_DISPATCH
+#else
+	// No computed goto on this compiler: fall back to the switch over the decoded stream
+	execute_decoded(memory, program, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs);
+#endif
+}
+
+void execute_profiled(std::array<int, memorySize>& memory, Profile& profile,
+			int* const acPtr, size_t* const icPtr, int* const irPtr,
+			size_t* const opCodePtr, size_t* const opPtr,
+			const std::vector<int>& inputs) {
+
+	using Clock = std::chrono::steady_clock;
+
+	size_t inputIndex{ 0 };
+	Command command;
+
+	do {
+		const size_t address = *icPtr;
+		if (address >= memorySize) throw std::runtime_error("Instruction counter out of range");
+		++profile.counts[address];
+
+		// A faulting step still costs its time before the exception leaves
+		const Clock::time_point start = Clock::now();
+		try {
+			command = step_instruction(decode(memory[address]), memory, acPtr, icPtr, irPtr,
+				opCodePtr, opPtr, inputs, inputIndex, [](size_t, int) {});
+		}
+		catch (...) {
+			profile.time[address] += Clock::now() - start;
+			throw;
+		}
+		profile.time[address] += Clock::now() - start;
+	} while (command != Command::halt);
+}
+
 bool validWord(int word) {
 	return (word >= minWord && word <= maxWord);
 }
 
-void dump(std::array <int, memorySize>& memory, int accumulator,
+size_t find_invalid_word(const int* words, size_t count) {
+	size_t i{ 0 };
+
+#if defined(__SSE2__) || defined(_M_X64)
+	// Sixteen words per block are compared four at a time and the out-of-range
+	// lanes OR'd together; only a block holding a bad word falls to the scalar scan
+	const __m128i below = _mm_set1_epi32(minWord);
+	const __m128i above = _mm_set1_epi32(maxWord);
+	for (; i + 16 <= count; i += 16) {
+		__m128i bad = _mm_setzero_si128();
+		for (size_t j = 0; j < 16; j += 4) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + i + j));
+			bad = _mm_or_si128(bad, _mm_or_si128(_mm_cmplt_epi32(v, below), _mm_cmpgt_epi32(v, above)));
+		}
+		if (_mm_movemask_epi8(bad) != 0) break;
+	}
+#endif
+
+	for (; i < count; ++i) {
+		if (!validWord(words[i])) return i;
+	}
+	return count;
+}
+
+std::vector<size_t> validate_images(const std::vector<std::array<int, memorySize>>& images) {
+	std::vector<size_t> firstInvalid(images.size());
+	for (size_t i = 0; i < images.size(); ++i) {
+		firstInvalid[i] = find_invalid_word(images[i].data(), memorySize);
+	}
+	return firstInvalid;
+}
+
+template <typename Word, size_t Cells>
+void dump(const std::array<Word, Cells>& memory, int accumulator,
 		size_t instructionCounter, size_t instructionRegister,
 		size_t operationCode, size_t operand) {
 
@@ -228,25 +996,35 @@ void dump(std::array <int, memorySize>& memory, int accumulator,
 	output("operationCode", 10, static_cast<int>(operationCode), false);
 	output("operand", 14, static_cast<int>(operand), false);
 
-	// Print memory
+	// Print memory; addresses and words widen with the operand field
+	constexpr int digits{ MachineConfig<Cells>::operandDigits };
 
-	for (size_t row = 0; row < memorySize; row += 10) {
+	for (size_t row = 0; row < Cells; row += 10) {
 		// Left column
-		std::cout << std::setw(2) << std::setfill('0') << row << " ";
+		std::cout << std::setw(digits) << std::setfill('0') << row << " ";
 
 		// Print 10 cells per row
 		for (size_t col = 0; col < 10; ++col) {
 			size_t index = row + col;
-			if (index >= memorySize) break;
+			if (index >= Cells) break;
 
 			std::ostringstream oss;
-			oss << std::internal << std::showpos << std::setw(5) << std::setfill('0') << memory[index];
+			oss << std::internal << std::showpos << std::setw(digits + 3) << std::setfill('0') << memory[index];
 			std::cout << oss.str();
 		}
 		std::cout << std::endl;
 	}
 }
 
+template void dump(const std::array<int, memorySize>& memory, int accumulator,
+	size_t instructionCounter, size_t instructionRegister, size_t operationCode, size_t operand);
+template void dump(const std::array<int16_t, memorySize>& memory, int accumulator,
+	size_t instructionCounter, size_t instructionRegister, size_t operationCode, size_t operand);
+template void dump(const std::array<int, 1000>& memory, int accumulator,
+	size_t instructionCounter, size_t instructionRegister, size_t operationCode, size_t operand);
+template void dump(const std::array<int, 10000>& memory, int accumulator,
+	size_t instructionCounter, size_t instructionRegister, size_t operationCode, size_t operand);
+
 void output(std::string label, int width, int value, bool sign) {
 
 	std::cout << std::setw(24) << std::left << label;
@@ -262,3 +1040,26 @@ void output(std::string label, int width, int value, bool sign) {
 		std::cout << std::setw(width) << std::setfill(' ') << value << std::endl;
 	}
 }
+
+RunResult run_to_result(Computron& computron) {
+	RunResult result;
+	try {
+		result.halted = computron.run();
+	}
+	catch (const std::runtime_error& e) {
+		result.error = e.what();
+	}
+
+	result.memory = computron.getMemory();
+	result.accumulator = computron.getAccumulator();
+	result.instructionCounter = computron.getInstructionCounter();
+	result.instructionRegister = computron.getInstructionRegister();
+	result.operationCode = computron.getOperationCode();
+	result.operand = computron.getOperand();
+	return result;
+}
+
+template class BasicComputron<int>;
+template class BasicComputron<int16_t>;
+template class BasicComputron<int, MachineConfig<1000>>;
+template class BasicComputron<int, MachineConfig<10000>>;
@@ -0,0 +1,252 @@
+#ifndef COMPUTRON_IMPL_H
+#define COMPUTRON_IMPL_H
+
+// Member definitions of BasicComputron. Private to the sources that
+// instantiate machines: computron.cpp for the flat memories, fork.cpp for
+// the paged ones, so tools that never fork do not link PagedMemory.
+
+#include "computron.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+template <typename Word, typename Config, typename Memory>
+void BasicComputron<Word, Config, Memory>::reset() {
+	accumulator = 0;
+	instructionCounter = 0;
+	instructionRegister = 0;
+	operationCode = 0;
+	operand = 0;
+	inputIndex = 0;
+	halted = false;
+
+	// verify() proved only the cells reachable from the old instruction counter
+	verified = false;
+}
+
+template <typename Word, typename Config, typename Memory>
+void BasicComputron<Word, Config, Memory>::load(const std::array<Word, memorySize>& image) {
+	memory.assign(image);
+	reset();
+}
+
+template <typename Word, typename Config, typename Memory>
+void BasicComputron<Word, Config, Memory>::load(const std::string& filename) {
+	memory.loadFile(filename);
+	reset();
+}
+
+template <typename Word, typename Config, typename Memory>
+void BasicComputron<Word, Config, Memory>::setInputs(const std::vector<int>& values) {
+	inputs.assign(values.begin(), values.end());
+	inputIndex = 0;
+}
+
+template <typename Word, typename Config, typename Memory>
+bool BasicComputron<Word, Config, Memory>::run(size_t maxSteps) {
+	if (halted) return true;
+	return verified ? runLoop<false>(maxSteps) : runLoop<true>(maxSteps);
+}
+
+// 'checked' is false only for images verify_program() accepted: control then
+// stays inside memory, every operand is in range and every opcode is known,
+// so the per-step checks below compile away
+template <typename Word, typename Config, typename Memory>
+template <bool checked>
+bool BasicComputron<Word, Config, Memory>::runLoop(size_t maxSteps) {
+	// Registers live in locals for the whole loop; nothing else can alias them
+	using Arithmetic = typename Config::Arithmetic;
+	int ac{ accumulator };
+	size_t ic{ instructionCounter };
+	int ir{ instructionRegister };
+	size_t opCode{ operationCode };
+	size_t op{ operand };
+	size_t input{ inputIndex };
+
+	auto writeBack = [&]() {
+		accumulator = ac;
+		instructionCounter = ic;
+		instructionRegister = ir;
+		operationCode = opCode;
+		operand = op;
+		inputIndex = input;
+	};
+
+	try {
+		for (size_t steps = 0; steps < maxSteps; ++steps) {
+			if constexpr (checked) {
+				if (ic >= memorySize) throw std::runtime_error("Instruction counter out of range");
+			}
+			ir = memory.read(ic);
+			opCode = static_cast<size_t>(ir / Config::operandBase);
+			op = static_cast<size_t>(ir % Config::operandBase);
+			if constexpr (checked) {
+				if (op >= memorySize) throw std::runtime_error("Operand out of range");
+			}
+
+			const Command command = checked ? opCodeToCommand(opCode) : static_cast<Command>(opCode);
+			switch (Arithmetic word{}; command) {
+
+			case Command::read:
+				if (input >= inputs.size()) throw std::runtime_error("Not enough input values");
+				word = inputs[input];
+				if (!Config::validWord(word)) throw std::runtime_error("Invalid word");
+				memory.write(op, static_cast<Word>(word));
+				++ic;
+				++input;
+				break;
+
+			case Command::write:
+				++ic;
+				break;
+
+			case Command::load:
+				ac = memory.read(op);
+				++ic;
+				break;
+
+			case Command::store:
+				memory.write(op, static_cast<Word>(ac));
+				++ic;
+				break;
+
+			case Command::add:
+				word = static_cast<Arithmetic>(ac) + memory.read(op);
+				if (!Config::validWord(word)) throw std::runtime_error("Addition out of range");
+				ac = static_cast<int>(word);
+				++ic;
+				break;
+
+			case Command::subtract:
+				word = static_cast<Arithmetic>(ac) - memory.read(op);
+				if (!Config::validWord(word)) throw std::runtime_error("Subtraction out of range");
+				ac = static_cast<int>(word);
+				++ic;
+				break;
+
+			case Command::multiply:
+				word = static_cast<Arithmetic>(ac) * memory.read(op);
+				if (!Config::validWord(word)) throw std::runtime_error("Multiplication out of range");
+				ac = static_cast<int>(word);
+				++ic;
+				break;
+
+			case Command::divide:
+				if (memory.read(op) == 0) throw std::runtime_error("Division by 0");
+				word = static_cast<Arithmetic>(ac) / memory.read(op);
+				if (!Config::validWord(word)) throw std::runtime_error("Division out of range");
+				ac = static_cast<int>(word);
+				++ic;
+				break;
+
+			case Command::branch:
+				ic = op;
+				break;
+
+			case Command::branchNeg:
+				ac < 0 ? ic = op : ++ic;
+				break;
+
+			case Command::branchZero:
+				ac == 0 ? ic = op : ++ic;
+				break;
+
+			case Command::halt:
+			default:
+				halted = true;
+				writeBack();
+				return true;
+			}
+		}
+	}
+	catch (...) {
+		writeBack();
+		throw;
+	}
+
+	writeBack();
+	return false;
+}
+
+template <typename Word, typename Config, typename Memory>
+bool BasicComputron<Word, Config, Memory>::verify() {
+	const auto& cells = memory.snapshot();
+	if constexpr (std::is_same_v<Word, int>) {
+		verified = verify_program(cells, instructionCounter);
+	}
+	else {
+		std::array<int, memorySize> words;
+		std::copy(cells.begin(), cells.end(), words.begin());
+		verified = verify_program(words, instructionCounter);
+	}
+	return verified;
+}
+
+template <typename Word, typename Config, typename Memory>
+bool BasicComputron<Word, Config, Memory>::isVerified() const {
+	return verified;
+}
+
+template <typename Word, typename Config, typename Memory>
+bool BasicComputron<Word, Config, Memory>::step() {
+	return run(1);
+}
+
+template <typename Word, typename Config, typename Memory>
+BasicComputron<Word, Config, Memory> BasicComputron<Word, Config, Memory>::fork() const {
+	// Copying the storage is the whole fork; PagedMemory copies only its page table
+	return *this;
+}
+
+template <typename Word, typename Config, typename Memory>
+bool BasicComputron<Word, Config, Memory>::isHalted() const {
+	return halted;
+}
+
+template <typename Word, typename Config, typename Memory>
+auto BasicComputron<Word, Config, Memory>::getMemory() const -> typename Memory::Snapshot {
+	return memory.snapshot();
+}
+
+template <typename Word, typename Config, typename Memory>
+const Memory& BasicComputron<Word, Config, Memory>::getStorage() const {
+	return memory;
+}
+
+template <typename Word, typename Config, typename Memory>
+int BasicComputron<Word, Config, Memory>::getAccumulator() const {
+	return accumulator;
+}
+
+template <typename Word, typename Config, typename Memory>
+size_t BasicComputron<Word, Config, Memory>::getInstructionCounter() const {
+	return instructionCounter;
+}
+
+template <typename Word, typename Config, typename Memory>
+int BasicComputron<Word, Config, Memory>::getInstructionRegister() const {
+	return instructionRegister;
+}
+
+template <typename Word, typename Config, typename Memory>
+size_t BasicComputron<Word, Config, Memory>::getOperationCode() const {
+	return operationCode;
+}
+
+template <typename Word, typename Config, typename Memory>
+size_t BasicComputron<Word, Config, Memory>::getOperand() const {
+	return operand;
+}
+
+template <typename Word, typename Config, typename Memory>
+size_t BasicComputron<Word, Config, Memory>::getInputIndex() const {
+	return inputIndex;
+}
+
+template <typename Word, typename Config, typename Memory>
+void BasicComputron<Word, Config, Memory>::dump() const {
+	::dump(memory.snapshot(), accumulator, instructionCounter, instructionRegister, operationCode, operand);
+}
+
+#endif // COMPUTRON_IMPL_H
@@ -0,0 +1,76 @@
+#include "fleet.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+
+FleetRunner::FleetRunner(size_t threads)
+	: threadCount{ threads != 0 ? threads : std::max<size_t>(1, std::thread::hardware_concurrency()) },
+	queues(threadCount) {
+}
+
+size_t FleetRunner::submit(FleetJob job) {
+	jobs.push_back(std::move(job));
+	return jobs.size() - 1;
+}
+
+size_t FleetRunner::getThreadCount() const {
+	return threadCount;
+}
+
+bool FleetRunner::take(size_t worker, size_t& job) {
+	{
+		WorkQueue& own = queues[worker];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (!own.jobs.empty()) {
+			job = own.jobs.back();
+			own.jobs.pop_back();
+			return true;
+		}
+	}
+
+	// Steal the oldest job of the next worker that still has some
+	for (size_t i = 1; i < threadCount; ++i) {
+		WorkQueue& victim = queues[(worker + i) % threadCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (!victim.jobs.empty()) {
+			job = victim.jobs.front();
+			victim.jobs.pop_front();
+			return true;
+		}
+	}
+
+	// Nothing is queued during a run, so empty everywhere means done
+	return false;
+}
+
+void FleetRunner::work(size_t worker, std::vector<RunResult>& results) {
+	Computron computron;
+	size_t job;
+
+	while (take(worker, job)) {
+		computron.load(jobs[job].image);
+		computron.setInputs(jobs[job].inputs);
+		results[job] = run_to_result(computron);
+	}
+}
+
+std::vector<RunResult> FleetRunner::run() {
+	std::vector<RunResult> results(jobs.size());
+
+	for (size_t job = 0; job < jobs.size(); ++job) {
+		queues[job % threadCount].jobs.push_back(job);
+	}
+
+	std::vector<std::thread> workers;
+	for (size_t worker = 1; worker < threadCount; ++worker) {
+		workers.emplace_back(&FleetRunner::work, this, worker, std::ref(results));
+	}
+	work(0, results);
+	for (auto& worker : workers) {
+		worker.join();
+	}
+
+	jobs.clear();
+	return results;
+}
@@ -0,0 +1,7 @@
+#include "fork.h"
+#include "computron_impl.h"
+
+// The paged machines are instantiated here rather than in computron.cpp, so
+// only programs that fork link them
+template class BasicComputron<int, StandardConfig, PagedMemory<int, memorySize>>;
+template class BasicComputron<int16_t, StandardConfig, PagedMemory<int16_t, memorySize>>;
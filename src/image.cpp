@@ -0,0 +1,252 @@
+#include "image.h"
+#include "fork.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr char imageMagic[4]{ 'C', 'T', 'R', 'N' };
+
+uint32_t fnv1a(const uint8_t* data, size_t size) {
+	uint32_t hash{ 2166136261u };
+	for (size_t i = 0; i < size; ++i) {
+		hash = (hash ^ data[i]) * 16777619u;
+	}
+	return hash;
+}
+
+void put16(std::vector<uint8_t>& out, uint16_t value) {
+	out.push_back(static_cast<uint8_t>(value));
+	out.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void put32(std::vector<uint8_t>& out, uint32_t value) {
+	put16(out, static_cast<uint16_t>(value));
+	put16(out, static_cast<uint16_t>(value >> 16));
+}
+
+void put64(std::vector<uint8_t>& out, uint64_t value) {
+	put32(out, static_cast<uint32_t>(value));
+	put32(out, static_cast<uint32_t>(value >> 32));
+}
+
+uint16_t get16(const uint8_t* data) {
+	return static_cast<uint16_t>(data[0] | (data[1] << 8));
+}
+
+uint32_t get32(const uint8_t* data) {
+	return get16(data) | (static_cast<uint32_t>(get16(data + 2)) << 16);
+}
+
+uint64_t get64(const uint8_t* data) {
+	return get32(data) | (static_cast<uint64_t>(get32(data + 4)) << 32);
+}
+
+// Widens the little-endian int16 words into memory and validates them
+size_t widen(const uint8_t* words, size_t count, std::array<int, memorySize>& memory) {
+	std::array<int16_t, memorySize> narrow;
+	std::memcpy(narrow.data(), words, count * sizeof(int16_t));
+
+	for (size_t i = 0; i < count; ++i) {
+		int16_t word = narrow[i];
+		if constexpr (std::endian::native == std::endian::big) {
+			word = static_cast<int16_t>((static_cast<uint16_t>(word) >> 8) | (static_cast<uint16_t>(word) << 8));
+		}
+		memory[i] = word;
+	}
+	if (find_invalid_word(memory.data(), count) != count) throw std::runtime_error("invalid_input");
+	return count;
+}
+
+} // namespace
+
+void encode_image(const std::array<int, memorySize>& memory, size_t count, std::vector<uint8_t>& out) {
+	if (count > memorySize) throw std::runtime_error("invalid_input");
+
+	if (find_invalid_word(memory.data(), count) != count) throw std::runtime_error("invalid_input");
+
+	std::vector<uint8_t> words;
+	words.reserve(count * sizeof(int16_t));
+	for (size_t i = 0; i < count; ++i) {
+		put16(words, static_cast<uint16_t>(static_cast<int16_t>(memory[i])));
+	}
+
+	out.insert(out.end(), std::begin(imageMagic), std::end(imageMagic));
+	put16(out, imageVersion);
+	put16(out, static_cast<uint16_t>(count));
+	put32(out, fnv1a(words.data(), words.size()));
+	out.insert(out.end(), words.begin(), words.end());
+}
+
+size_t decode_image(const uint8_t* data, size_t size, std::array<int, memorySize>& memory) {
+	if (size < imageHeaderSize || std::memcmp(data, imageMagic, sizeof(imageMagic)) != 0)
+		throw std::runtime_error("invalid_input");
+	if (get16(data + 4) != imageVersion) throw std::runtime_error("invalid_input");
+
+	const size_t count = get16(data + 6);
+	const size_t wordBytes = count * sizeof(int16_t);
+	if (count > memorySize || size < imageHeaderSize + wordBytes) throw std::runtime_error("invalid_input");
+
+	const uint8_t* words = data + imageHeaderSize;
+	if (fnv1a(words, wordBytes) != get32(data + 8)) throw std::runtime_error("invalid_input");
+
+	return widen(words, count, memory);
+}
+
+void save_image(const std::array<int, memorySize>& memory, size_t count, const std::string& filename) {
+	std::vector<uint8_t> bytes;
+	encode_image(memory, count, bytes);
+
+	std::FILE* file = std::fopen(filename.c_str(), "wb");
+	if (!file) throw std::runtime_error("Cannot write " + filename);
+	const bool written = std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+	if (std::fclose(file) != 0 || !written) throw std::runtime_error("Cannot write " + filename);
+}
+
+size_t load_image(std::array<int, memorySize>& memory, const std::string& filename) {
+	// Header and words are two fixed-size reads; the largest image is 212 bytes
+	std::array<uint8_t, imageHeaderSize + memorySize * sizeof(int16_t)> bytes;
+
+	std::FILE* file = std::fopen(filename.c_str(), "rb");
+	if (!file) throw std::runtime_error("invalid_input");
+	const size_t length = std::fread(bytes.data(), 1, bytes.size(), file);
+	std::fclose(file);
+
+	return decode_image(bytes.data(), length, memory);
+}
+
+void convert_text_to_image(const std::string& textFile, const std::string& imageFile) {
+	std::array<int, memorySize> memory{ 0 };
+	const size_t count = load_from_file(memory, textFile);
+	save_image(memory, count, imageFile);
+}
+
+namespace {
+
+constexpr char checkpointMagic[4]{ 'C', 'T', 'C', 'K' };
+
+// Reads the checkpoint body front to back; every read is bounds-checked
+struct Reader {
+	const uint8_t* data;
+	size_t size;
+	size_t offset{ 0 };
+
+	const uint8_t* take(size_t count) {
+		if (count > size - offset) throw std::runtime_error("invalid_input");
+		const uint8_t* at = data + offset;
+		offset += count;
+		return at;
+	}
+
+	uint8_t u8() { return *take(1); }
+	uint32_t u32() { return get32(take(4)); }
+	int32_t i32() { return static_cast<int32_t>(u32()); }
+	uint64_t u64() { return get64(take(8)); }
+};
+
+} // namespace
+
+template <typename Word, typename Config, typename Memory>
+void BasicComputron<Word, Config, Memory>::checkpoint(std::vector<uint8_t>& out) const {
+	// load() takes any int, so the width follows the words actually in memory
+	const auto& cells = memory.snapshot();
+	const bool narrow = std::all_of(cells.begin(), cells.end(), [](Word word) {
+		return word >= std::numeric_limits<int16_t>::min() && word <= std::numeric_limits<int16_t>::max();
+	});
+	const size_t wordBytes = narrow ? 2 : 4;
+
+	std::vector<uint8_t> body;
+	body.reserve(42 + 4 * inputs.size() + memorySize * wordBytes);
+	put32(body, static_cast<uint32_t>(accumulator));
+	put32(body, static_cast<uint32_t>(instructionCounter));
+	put32(body, static_cast<uint32_t>(instructionRegister));
+	put64(body, operationCode);
+	put64(body, operand);
+	put32(body, static_cast<uint32_t>(inputIndex));
+	body.push_back(halted ? 1 : 0);
+	body.push_back(static_cast<uint8_t>(wordBytes));
+	put32(body, static_cast<uint32_t>(inputs.size()));
+	for (int value : inputs) {
+		put32(body, static_cast<uint32_t>(value));
+	}
+	for (Word word : cells) {
+		if (narrow) put16(body, static_cast<uint16_t>(word));
+		else put32(body, static_cast<uint32_t>(word));
+	}
+
+	out.insert(out.end(), std::begin(checkpointMagic), std::end(checkpointMagic));
+	put16(out, checkpointVersion);
+	put16(out, static_cast<uint16_t>(memorySize));
+	put32(out, fnv1a(body.data(), body.size()));
+	out.insert(out.end(), body.begin(), body.end());
+}
+
+template <typename Word, typename Config, typename Memory>
+void BasicComputron<Word, Config, Memory>::restore(const uint8_t* data, size_t size) {
+	if (size < checkpointHeaderSize || std::memcmp(data, checkpointMagic, sizeof(checkpointMagic)) != 0)
+		throw std::runtime_error("invalid_input");
+	if (get16(data + 4) != checkpointVersion || get16(data + 6) != memorySize)
+		throw std::runtime_error("invalid_input");
+	if (fnv1a(data + checkpointHeaderSize, size - checkpointHeaderSize) != get32(data + 8))
+		throw std::runtime_error("invalid_input");
+
+	// Decode into locals first so a bad blob leaves the machine as it was
+	Reader body{ data + checkpointHeaderSize, size - checkpointHeaderSize };
+	const int ac = body.i32();
+	const size_t ic = body.u32();
+	const int ir = body.i32();
+	const size_t opCode = static_cast<size_t>(body.u64());
+	const size_t op = static_cast<size_t>(body.u64());
+	const size_t input = body.u32();
+	const bool isHalted = body.u8() != 0;
+	const size_t wordBytes = body.u8();
+	if (wordBytes != 2 && wordBytes != 4) throw std::runtime_error("invalid_input");
+
+	const size_t inputCount = body.u32();
+	if (inputCount > (body.size - body.offset) / 4) throw std::runtime_error("invalid_input");
+	std::vector<int> values(inputCount);
+	for (int& value : values) {
+		value = body.i32();
+	}
+
+	// Words are restored as load() would take them; only the storage type bounds them
+	std::array<Word, memorySize> cells;
+	for (Word& cell : cells) {
+		const int word = wordBytes == 2 ? static_cast<int16_t>(get16(body.take(2))) : body.i32();
+		if (word < std::numeric_limits<Word>::min() || word > std::numeric_limits<Word>::max())
+			throw std::runtime_error("invalid_input");
+		cell = static_cast<Word>(word);
+	}
+
+	if (body.offset != body.size || ic > memorySize || input > inputCount)
+		throw std::runtime_error("invalid_input");
+
+	memory.assign(cells);
+	inputs = std::move(values);
+	accumulator = ac;
+	instructionCounter = ic;
+	instructionRegister = ir;
+	operationCode = opCode;
+	operand = op;
+	inputIndex = input;
+	halted = isHalted;
+	verified = false;
+}
+
+// The checkpoint members live here, next to the helpers they share with images
+template void BasicComputron<int>::checkpoint(std::vector<uint8_t>&) const;
+template void BasicComputron<int>::restore(const uint8_t*, size_t);
+template void BasicComputron<int16_t>::checkpoint(std::vector<uint8_t>&) const;
+template void BasicComputron<int16_t>::restore(const uint8_t*, size_t);
+template void BasicComputron<int, MachineConfig<1000>>::checkpoint(std::vector<uint8_t>&) const;
+template void BasicComputron<int, MachineConfig<1000>>::restore(const uint8_t*, size_t);
+template void BasicComputron<int, MachineConfig<10000>>::checkpoint(std::vector<uint8_t>&) const;
+template void BasicComputron<int, MachineConfig<10000>>::restore(const uint8_t*, size_t);
+template void ForkableComputron::checkpoint(std::vector<uint8_t>&) const;
+template void ForkableComputron::restore(const uint8_t*, size_t);
+template void CompactForkableComputron::checkpoint(std::vector<uint8_t>&) const;
+template void CompactForkableComputron::restore(const uint8_t*, size_t);
@@ -0,0 +1,183 @@
+#include "interactive.h"
+
+#include <stdexcept>
+
+Channel::Channel(size_t capacity)
+	: capacity{ capacity } {
+}
+
+bool Channel::empty() const {
+	return values.empty();
+}
+
+bool Channel::full() const {
+	return values.size() >= capacity;
+}
+
+size_t Channel::size() const {
+	return values.size();
+}
+
+bool Channel::push(int value) {
+	if (full()) return false;
+	values.push_back(value);
+	return true;
+}
+
+int Channel::pop() {
+	if (values.empty()) throw std::runtime_error("Channel is empty");
+	const int value = values.front();
+	values.pop_front();
+	return value;
+}
+
+ComputronTask ComputronTask::promise_type::get_return_object() {
+	return ComputronTask(std::coroutine_handle<promise_type>::from_promise(*this));
+}
+
+ComputronTask::ComputronTask(std::coroutine_handle<promise_type> handle)
+	: handle{ handle } {
+}
+
+ComputronTask::ComputronTask(ComputronTask&& other) noexcept
+	: handle{ other.handle } {
+	other.handle = nullptr;
+}
+
+ComputronTask& ComputronTask::operator=(ComputronTask&& other) noexcept {
+	if (this != &other) {
+		if (handle) handle.destroy();
+		handle = other.handle;
+		other.handle = nullptr;
+	}
+	return *this;
+}
+
+ComputronTask::~ComputronTask() {
+	if (handle) handle.destroy();
+}
+
+bool ComputronTask::resume() {
+	if (!handle || handle.done()) return false;
+
+	handle.promise().waiting = Suspension::none;
+	handle.resume();
+
+	if (handle.promise().error) {
+		std::exception_ptr error = handle.promise().error;
+		handle.promise().error = nullptr;
+		std::rethrow_exception(error);
+	}
+	return !handle.done();
+}
+
+bool ComputronTask::done() const {
+	return !handle || handle.done();
+}
+
+Suspension ComputronTask::waitingFor() const {
+	return handle ? handle.promise().waiting : Suspension::none;
+}
+
+namespace {
+
+// Records why the machine stopped before handing control back to the host
+struct WaitFor {
+	Suspension reason;
+
+	bool await_ready() const noexcept { return false; }
+	void await_suspend(std::coroutine_handle<ComputronTask::promise_type> handle) const noexcept {
+		handle.promise().waiting = reason;
+	}
+	void await_resume() const noexcept {}
+};
+
+} // namespace
+
+ComputronTask execute_interactive(std::array<int, memorySize>& memory, int* const acPtr,
+		size_t* const icPtr, int* const irPtr,
+		size_t* const opCodePtr, size_t* const opPtr,
+		Channel& input, Channel& output) {
+
+	for (;;) {
+		if (*icPtr >= memorySize) throw std::runtime_error("Instruction counter out of range");
+		*irPtr = memory[*icPtr];
+
+		*opCodePtr = static_cast<size_t>((*irPtr) / 100);
+		*opPtr = static_cast<size_t>((*irPtr) % 100);
+
+		if (*opPtr >= memorySize) throw std::runtime_error("Operand out of range");
+
+		switch (int word{}; opCodeToCommand(*opCodePtr)) {
+
+		case Command::read:
+			while (input.empty()) co_await WaitFor{ Suspension::input };
+			word = input.pop();
+			if (!validWord(word)) throw std::runtime_error("Invalid word");
+			memory[*opPtr] = word;
+			++(*icPtr);
+			break;
+
+		case Command::write:
+			while (output.full()) co_await WaitFor{ Suspension::output };
+			output.push(memory[*opPtr]);
+			++(*icPtr);
+			break;
+
+		case Command::load:
+			*acPtr = memory[*opPtr];
+			++(*icPtr);
+			break;
+
+		case Command::store:
+			memory[*opPtr] = *acPtr;
+			++(*icPtr);
+			break;
+
+		case Command::add:
+			word = *acPtr + memory[*opPtr];
+			if (!validWord(word)) throw std::runtime_error("Addition out of range");
+			*acPtr = word;
+			++(*icPtr);
+			break;
+
+		case Command::subtract:
+			word = *acPtr - memory[*opPtr];
+			if (!validWord(word)) throw std::runtime_error("Subtraction out of range");
+			*acPtr = word;
+			++(*icPtr);
+			break;
+
+		case Command::multiply:
+			word = *acPtr * memory[*opPtr];
+			if (!validWord(word)) throw std::runtime_error("Multiplication out of range");
+			*acPtr = word;
+			++(*icPtr);
+			break;
+
+		case Command::divide:
+			if (memory[*opPtr] == 0) throw std::runtime_error("Division by 0");
+			word = *acPtr / memory[*opPtr];
+			if (!validWord(word)) throw std::runtime_error("Division out of range");
+			*acPtr = word;
+			++(*icPtr);
+			break;
+
+		case Command::branch:
+			*icPtr = *opPtr;
+			break;
+
+		case Command::branchNeg:
+			*acPtr < 0 ? *icPtr = *opPtr : ++(*icPtr);
+			break;
+
+		case Command::branchZero:
+			*acPtr == 0 ? *icPtr = *opPtr : ++(*icPtr);
+			break;
+
+		case Command::halt:
+		default:
+			co_return;
+		}
+	}
+}
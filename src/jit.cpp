@@ -0,0 +1,259 @@
+#include "jit.h"
+
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define COMPUTRON_JIT_X86_64
+#include <sys/mman.h>
+#endif
+
+// The generated code addresses the context through rbx with these offsets
+static_assert(offsetof(CompiledContext, memory) == 0);
+static_assert(offsetof(CompiledContext, inputs) == 8);
+static_assert(offsetof(CompiledContext, inputCount) == 16);
+static_assert(offsetof(CompiledContext, inputIndex) == 24);
+static_assert(offsetof(CompiledContext, instructionCounter) == 32);
+static_assert(offsetof(CompiledContext, accumulator) == 40);
+
+namespace {
+
+// Register use in the generated code:
+//   eax - accumulator
+//   rbx - CompiledContext*
+//   r12 - memory base
+//   ecx, edx, rcx, rdx - scratch
+class CodeBuffer {
+public:
+	void emit(std::initializer_list<uint8_t> values) {
+		bytes.insert(bytes.end(), values);
+	}
+
+	void emit32(int32_t value) {
+		for (int i = 0; i < 4; ++i) {
+			bytes.push_back(static_cast<uint8_t>(static_cast<uint32_t>(value) >> (8 * i)));
+		}
+	}
+
+	// [r12 + disp32] addressing for the cell 'operand'
+	void memoryOperand(uint8_t reg, size_t operand) {
+		emit({ static_cast<uint8_t>(0x80 | (reg << 3) | 0x04), 0x24 });
+		emit32(static_cast<int32_t>(operand * sizeof(int)));
+	}
+
+	// Jump with a rel32 placeholder to be patched once 'target' has a location
+	void jump(std::initializer_list<uint8_t> opcode, size_t target, bool toExit) {
+		emit(opcode);
+		fixups.push_back({ bytes.size(), target, toExit });
+		emit32(0);
+	}
+
+	// Range check of edx against [minWord, maxWord], leaving at 'exit' on failure
+	void checkEdx(size_t exit) {
+		emit({ 0x81, 0xFA });
+		emit32(maxWord);
+		jump({ 0x0F, 0x8F }, exit, true); // jg
+		emit({ 0x81, 0xFA });
+		emit32(minWord);
+		jump({ 0x0F, 0x8C }, exit, true); // jl
+	}
+
+	struct Fixup {
+		size_t at;
+		size_t target;
+		bool toExit;
+	};
+
+	std::vector<uint8_t> bytes;
+	std::vector<Fixup> fixups;
+};
+
+} // namespace
+
+JitProgram::JitProgram(const std::array<int, memorySize>& memory, size_t entry)
+	: entry{ entry }, codeWords{ memory } {
+
+	if (entry >= memorySize) return;
+
+	isCode = reachable_cells(memory, entry);
+
+#ifdef COMPUTRON_JIT_X86_64
+	CodeBuffer buffer;
+	std::array<size_t, memorySize> labels{};
+
+	// push rbx; push r12; mov rbx, rdi; mov r12, [rdi]; mov eax, [rdi + 40]
+	buffer.emit({ 0x53, 0x41, 0x54, 0x48, 0x89, 0xFB, 0x4C, 0x8B, 0x27, 0x8B, 0x47, 0x28 });
+	buffer.jump({ 0xE9 }, entry, false);
+
+	for (size_t address = 0; address < memorySize; ++address) {
+		if (!isCode[address]) continue;
+		labels[address] = buffer.bytes.size();
+
+		const DecodedInstruction decoded = decode(memory[address]);
+		const size_t operand = decoded.operand;
+
+		// Faults, halts and writes into compiled code are left to the interpreter
+		if (operand >= memorySize || decoded.command == Command::halt ||
+			((decoded.command == Command::read || decoded.command == Command::store) && isCode[operand])) {
+			buffer.jump({ 0xE9 }, address, true);
+			continue;
+		}
+
+		switch (decoded.command) {
+		case Command::read:
+			buffer.emit({ 0x48, 0x8B, 0x4B, 0x18 });      // mov rcx, [rbx + inputIndex]
+			buffer.emit({ 0x48, 0x3B, 0x4B, 0x10 });      // cmp rcx, [rbx + inputCount]
+			buffer.jump({ 0x0F, 0x83 }, address, true);   // jae exit
+			buffer.emit({ 0x48, 0x8B, 0x53, 0x08 });      // mov rdx, [rbx + inputs]
+			buffer.emit({ 0x8B, 0x14, 0x8A });            // mov edx, [rdx + rcx * 4]
+			buffer.checkEdx(address);
+			buffer.emit({ 0x41, 0x89 });                  // mov [cell], edx
+			buffer.memoryOperand(2, operand);
+			buffer.emit({ 0x48, 0xFF, 0xC1 });            // inc rcx
+			buffer.emit({ 0x48, 0x89, 0x4B, 0x18 });      // mov [rbx + inputIndex], rcx
+			break;
+
+		case Command::write:
+			break;
+
+		case Command::load:
+			buffer.emit({ 0x41, 0x8B });                  // mov eax, [cell]
+			buffer.memoryOperand(0, operand);
+			break;
+
+		case Command::store:
+			buffer.emit({ 0x41, 0x89 });                  // mov [cell], eax
+			buffer.memoryOperand(0, operand);
+			break;
+
+		case Command::add:
+		case Command::subtract:
+		case Command::multiply:
+			buffer.emit({ 0x89, 0xC2 });                  // mov edx, eax
+			if (decoded.command == Command::add) buffer.emit({ 0x41, 0x03 });
+			else if (decoded.command == Command::subtract) buffer.emit({ 0x41, 0x2B });
+			else buffer.emit({ 0x41, 0x0F, 0xAF });
+			buffer.memoryOperand(2, operand);             // op edx, [cell]
+			buffer.checkEdx(address);
+			buffer.emit({ 0x89, 0xD0 });                  // mov eax, edx
+			break;
+
+		case Command::divide:
+			buffer.emit({ 0x41, 0x83 });                  // cmp dword [cell], 0
+			buffer.memoryOperand(7, operand);
+			buffer.emit({ 0x00 });
+			buffer.jump({ 0x0F, 0x84 }, address, true);   // je exit
+			buffer.emit({ 0x89, 0xC1, 0x99, 0x41, 0xF7 }); // mov ecx, eax; cdq; idiv [cell]
+			buffer.memoryOperand(7, operand);
+			buffer.emit({ 0x89, 0xC2, 0x89, 0xC8 });      // mov edx, eax; mov eax, ecx
+			buffer.checkEdx(address);
+			buffer.emit({ 0x89, 0xD0 });                  // mov eax, edx
+			break;
+
+		case Command::branch:
+			buffer.jump({ 0xE9 }, operand, false);
+			continue;
+
+		case Command::branchNeg:
+			buffer.emit({ 0x85, 0xC0 });                  // test eax, eax
+			buffer.jump({ 0x0F, 0x8C }, operand, false);  // jl
+			break;
+
+		case Command::branchZero:
+			buffer.emit({ 0x85, 0xC0 });                  // test eax, eax
+			buffer.jump({ 0x0F, 0x84 }, operand, false);  // je
+			break;
+
+		default:
+			break;
+		}
+
+		// Falling through to the next cell: it is code too, and is emitted next,
+		// unless this was the last cell of memory
+		if (address + 1 == memorySize) buffer.jump({ 0xE9 }, memorySize, true);
+	}
+
+	// One stub per side exit: record where the interpreter must resume
+	std::array<size_t, memorySize + 1> exits{};
+	std::array<bool, memorySize + 1> hasExit{};
+	for (const auto& fixup : buffer.fixups) {
+		if (fixup.toExit) hasExit[fixup.target] = true;
+	}
+
+	std::vector<size_t> exitJumps;
+	for (size_t address = 0; address <= memorySize; ++address) {
+		if (!hasExit[address]) continue;
+		exits[address] = buffer.bytes.size();
+		buffer.emit({ 0x48, 0xC7, 0x43, 0x20 });          // mov qword [rbx + instructionCounter], imm32
+		buffer.emit32(static_cast<int32_t>(address));
+		buffer.emit({ 0xE9 });
+		exitJumps.push_back(buffer.bytes.size());
+		buffer.emit32(0);
+	}
+
+	// mov [rbx + accumulator], eax; pop r12; pop rbx; ret
+	const size_t epilogue = buffer.bytes.size();
+	buffer.emit({ 0x89, 0x43, 0x28, 0x41, 0x5C, 0x5B, 0xC3 });
+
+	auto patch = [&buffer](size_t at, size_t target) {
+		const int32_t relative = static_cast<int32_t>(target) - static_cast<int32_t>(at + 4);
+		std::memcpy(&buffer.bytes[at], &relative, sizeof(relative));
+	};
+	for (const auto& fixup : buffer.fixups) {
+		patch(fixup.at, fixup.toExit ? exits[fixup.target] : labels[fixup.target]);
+	}
+	for (size_t at : exitJumps) {
+		patch(at, epilogue);
+	}
+
+	void* pages = mmap(nullptr, buffer.bytes.size(), PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (pages == MAP_FAILED) return;
+	std::memcpy(pages, buffer.bytes.data(), buffer.bytes.size());
+	if (mprotect(pages, buffer.bytes.size(), PROT_READ | PROT_EXEC) != 0) {
+		munmap(pages, buffer.bytes.size());
+		return;
+	}
+	code = pages;
+	codeSize = buffer.bytes.size();
+#endif
+}
+
+JitProgram::~JitProgram() {
+#ifdef COMPUTRON_JIT_X86_64
+	if (code) munmap(code, codeSize);
+#endif
+}
+
+bool JitProgram::compiled() const {
+	return code != nullptr;
+}
+
+void JitProgram::run(std::array<int, memorySize>& memory, int* const acPtr,
+		size_t* const icPtr, int* const irPtr,
+		size_t* const opCodePtr, size_t* const opPtr,
+		const std::vector<int>& inputs) const {
+
+	bool matches = compiled() && *icPtr == entry;
+	for (size_t i = 0; matches && i < memorySize; ++i) {
+		if (isCode[i] && memory[i] != codeWords[i]) matches = false;
+	}
+
+	// Not compiled for this entry point or this code: interpret everything
+	if (!matches) {
+		execute(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs);
+		return;
+	}
+
+	run_compiled(reinterpret_cast<EntryPoint>(code), memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs);
+}
+
+void execute_jit(std::array<int, memorySize>& memory, int* const acPtr,
+		size_t* const icPtr, int* const irPtr,
+		size_t* const opCodePtr, size_t* const opPtr,
+		const std::vector<int>& inputs) {
+
+	const JitProgram program(memory, *icPtr);
+	program.run(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs);
+}
@@ -0,0 +1,84 @@
+#include "loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+// Runs load(i) for every i in [0, count) on a pool of threads that pull the
+// next index from a shared counter, so slow files do not hold up a fixed share
+template <typename Load>
+void parallel_for(size_t count, size_t threads, Load load) {
+	if (threads == 0) threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+	threads = std::min(threads, std::max<size_t>(1, count));
+
+	std::atomic<size_t> next{ 0 };
+	auto worker = [&]() {
+		for (size_t i = next++; i < count; i = next++) {
+			load(i);
+		}
+	};
+
+	std::vector<std::thread> pool;
+	for (size_t t = 1; t < threads; ++t) {
+		pool.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : pool) {
+		thread.join();
+	}
+}
+
+} // namespace
+
+std::vector<LoadedProgram> load_directory(const std::string& directory, size_t threads) {
+	std::vector<LoadedProgram> programs;
+
+	std::error_code error;
+	for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+		if (!entry.is_regular_file()) continue;
+		LoadedProgram program;
+		program.source = entry.path().string();
+		programs.push_back(std::move(program));
+	}
+	if (error) throw std::runtime_error("invalid_input");
+
+	std::sort(programs.begin(), programs.end(),
+		[](const LoadedProgram& a, const LoadedProgram& b) { return a.source < b.source; });
+
+	parallel_for(programs.size(), threads, [&programs](size_t i) {
+		LoadedProgram& program = programs[i];
+		try {
+			program.count = std::filesystem::path(program.source).extension() == ".img"
+				? load_image(program.memory, program.source)
+				: load_from_file(program.memory, program.source);
+		}
+		catch (const std::runtime_error& e) {
+			program.memory.fill(0);
+			program.count = 0;
+			program.error = e.what();
+		}
+	});
+	return programs;
+}
+
+std::vector<LoadedProgram> load_bundle(const BundleReader& bundle, size_t threads) {
+	std::vector<LoadedProgram> programs(bundle.size());
+
+	parallel_for(programs.size(), threads, [&programs, &bundle](size_t i) {
+		LoadedProgram& program = programs[i];
+		program.source = "<bundle>#" + std::to_string(i);
+		try {
+			program.count = bundle.load(i, program.memory);
+		}
+		catch (const std::runtime_error& e) {
+			program.memory.fill(0);
+			program.count = 0;
+			program.error = e.what();
+		}
+	});
+	return programs;
+}
@@ -0,0 +1,231 @@
+#include "native.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define COMPUTRON_NATIVE_DLOPEN
+#include <dlfcn.h>
+#include <spawn.h>
+#include <sys/wait.h>
+
+extern char** environ;
+#endif
+
+void translate_to_cpp(const std::array<int, memorySize>& memory, std::ostream& out, size_t entry) {
+	if (entry >= memorySize) throw std::runtime_error("Instruction counter out of range");
+
+	const std::array<bool, memorySize> isCode = reachable_cells(memory, entry);
+
+	// Basic blocks start at the entry point and at every branch target
+	std::array<bool, memorySize> isLeader{};
+	isLeader[entry] = true;
+	for (size_t address = 0; address < memorySize; ++address) {
+		if (!isCode[address]) continue;
+		const DecodedInstruction decoded = decode(memory[address]);
+		if (decoded.operand < memorySize && (decoded.command == Command::branch ||
+			decoded.command == Command::branchNeg || decoded.command == Command::branchZero)) {
+			isLeader[decoded.operand] = true;
+		}
+	}
+
+	auto label = [](size_t address) {
+		std::ostringstream oss;
+		oss << "block_" << std::setw(2) << std::setfill('0') << address;
+		return oss.str();
+	};
+
+	out << "// Generated by translate_to_cpp, do not edit\n"
+		<< "#include <cstddef>\n\n"
+		<< "struct CompiledContext {\n"
+		<< "\tint* memory;\n"
+		<< "\tconst int* inputs;\n"
+		<< "\tstd::size_t inputCount;\n"
+		<< "\tstd::size_t inputIndex;\n"
+		<< "\tstd::size_t instructionCounter;\n"
+		<< "\tint accumulator;\n"
+		<< "};\n\n"
+		<< "#define LEAVE(address) do { context->instructionCounter = address; goto leave; } while (0)\n"
+		<< "#define CHECK_WORD(address) if (word < " << minWord << " || word > " << maxWord << ") LEAVE(address)\n\n";
+
+	// The words the translation was made from, so the loader can refuse a
+	// memory image whose code differs
+	out << "extern \"C\" const std::size_t computron_entry = " << entry << ";\n";
+	out << "extern \"C\" const int computron_words[" << memorySize << "] = {";
+	for (size_t i = 0; i < memorySize; ++i) {
+		out << (i % 10 == 0 ? "\n\t" : " ") << memory[i] << ",";
+	}
+	out << "\n};\n";
+	out << "extern \"C\" const unsigned char computron_is_code[" << memorySize << "] = {";
+	for (size_t i = 0; i < memorySize; ++i) {
+		out << (i % 10 == 0 ? "\n\t" : " ") << (isCode[i] ? 1 : 0) << ",";
+	}
+	out << "\n};\n\n";
+
+	out << "extern \"C\" void computron_run(CompiledContext* context) {\n"
+		<< "\tint* const memory = context->memory;\n"
+		<< "\tint accumulator = context->accumulator;\n"
+		<< "\tlong long word;\n"
+		<< "\tgoto " << label(entry) << ";\n";
+
+	for (size_t address = 0; address < memorySize; ++address) {
+		if (!isCode[address]) continue;
+
+		const DecodedInstruction decoded = decode(memory[address]);
+		const size_t operand = decoded.operand;
+
+		if (isLeader[address]) out << "\n" << label(address) << ":\n";
+		out << "\t// " << std::setw(2) << std::setfill('0') << address << ": " << memory[address] << "\n";
+
+		if (operand >= memorySize || decoded.command == Command::halt ||
+			((decoded.command == Command::read || decoded.command == Command::store) && isCode[operand])) {
+			out << "\tLEAVE(" << address << ");\n";
+			continue;
+		}
+
+		const std::string cell = "memory[" + std::to_string(operand) + "]";
+		switch (decoded.command) {
+		case Command::read:
+			out << "\tif (context->inputIndex >= context->inputCount) LEAVE(" << address << ");\n"
+				<< "\tword = context->inputs[context->inputIndex];\n"
+				<< "\tCHECK_WORD(" << address << ");\n"
+				<< "\t" << cell << " = static_cast<int>(word);\n"
+				<< "\t++context->inputIndex;\n";
+			break;
+		case Command::write:
+			break;
+		case Command::load:
+			out << "\taccumulator = " << cell << ";\n";
+			break;
+		case Command::store:
+			out << "\t" << cell << " = accumulator;\n";
+			break;
+		case Command::add:
+			out << "\tword = static_cast<long long>(accumulator) + " << cell << ";\n"
+				<< "\tCHECK_WORD(" << address << ");\n"
+				<< "\taccumulator = static_cast<int>(word);\n";
+			break;
+		case Command::subtract:
+			out << "\tword = static_cast<long long>(accumulator) - " << cell << ";\n"
+				<< "\tCHECK_WORD(" << address << ");\n"
+				<< "\taccumulator = static_cast<int>(word);\n";
+			break;
+		case Command::multiply:
+			out << "\tword = static_cast<long long>(accumulator) * " << cell << ";\n"
+				<< "\tCHECK_WORD(" << address << ");\n"
+				<< "\taccumulator = static_cast<int>(word);\n";
+			break;
+		case Command::divide:
+			out << "\tif (" << cell << " == 0) LEAVE(" << address << ");\n"
+				<< "\tword = static_cast<long long>(accumulator) / " << cell << ";\n"
+				<< "\tCHECK_WORD(" << address << ");\n"
+				<< "\taccumulator = static_cast<int>(word);\n";
+			break;
+		case Command::branch:
+			out << "\tgoto " << label(operand) << ";\n";
+			continue;
+		case Command::branchNeg:
+			out << "\tif (accumulator < 0) goto " << label(operand) << ";\n";
+			break;
+		case Command::branchZero:
+			out << "\tif (accumulator == 0) goto " << label(operand) << ";\n";
+			break;
+		default:
+			break;
+		}
+
+		if (address + 1 == memorySize) out << "\tLEAVE(" << memorySize << ");\n";
+	}
+
+	out << "\nleave:\n"
+		<< "\tcontext->accumulator = accumulator;\n"
+		<< "}\n";
+}
+
+void NativeProgram::compile(const std::array<int, memorySize>& memory,
+		const std::string& libraryPath, size_t entry) {
+
+	const std::string sourcePath = libraryPath + ".cpp";
+	{
+		std::ofstream source(sourcePath);
+		if (!source) throw std::runtime_error("Cannot write " + sourcePath);
+		translate_to_cpp(memory, source, entry);
+	}
+
+#ifdef COMPUTRON_NATIVE_DLOPEN
+	// The compiler gets its arguments as an argv, never through a shell, so
+	// quotes, '$' or backticks in the paths stay part of the file names.
+	// $CXX may still carry options, split on whitespace.
+	std::vector<std::string> args;
+	const char* compiler = std::getenv("CXX");
+	std::istringstream words(compiler && *compiler ? compiler : "c++");
+	for (std::string word; words >> word;) args.push_back(word);
+	if (args.empty()) args.push_back("c++");
+	args.insert(args.end(), { "-O2", "-shared", "-fPIC", "-o", libraryPath, sourcePath });
+
+	std::vector<char*> argv;
+	for (std::string& arg : args) argv.push_back(arg.data());
+	argv.push_back(nullptr);
+
+	pid_t pid;
+	if (posix_spawnp(&pid, argv[0], nullptr, nullptr, argv.data(), environ) != 0)
+		throw std::runtime_error("Native compilation failed");
+	int status{ 0 };
+	while (waitpid(pid, &status, 0) < 0) {
+		if (errno != EINTR) throw std::runtime_error("Native compilation failed");
+	}
+	if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) throw std::runtime_error("Native compilation failed");
+#else
+	throw std::runtime_error("Native programs are not supported on this platform");
+#endif
+}
+
+NativeProgram::NativeProgram(const std::string& libraryPath) {
+#ifdef COMPUTRON_NATIVE_DLOPEN
+	// dlopen needs a path, not a bare name, to load from the current directory
+	const std::string path = libraryPath.find('/') == std::string::npos ? "./" + libraryPath : libraryPath;
+	library = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+	if (!library) throw std::runtime_error("Cannot load " + libraryPath);
+
+	function = reinterpret_cast<EntryPoint>(dlsym(library, "computron_run"));
+	codeWords = static_cast<const int*>(dlsym(library, "computron_words"));
+	isCode = static_cast<const unsigned char*>(dlsym(library, "computron_is_code"));
+	const auto* entryPoint = static_cast<const size_t*>(dlsym(library, "computron_entry"));
+	if (!function || !codeWords || !isCode || !entryPoint) {
+		dlclose(library);
+		throw std::runtime_error("Not a compiled program: " + libraryPath);
+	}
+	entry = *entryPoint;
+#else
+	throw std::runtime_error("Native programs are not supported on this platform");
+#endif
+}
+
+NativeProgram::~NativeProgram() {
+#ifdef COMPUTRON_NATIVE_DLOPEN
+	if (library) dlclose(library);
+#endif
+}
+
+void NativeProgram::run(std::array<int, memorySize>& memory, int* const acPtr,
+		size_t* const icPtr, int* const irPtr,
+		size_t* const opCodePtr, size_t* const opPtr,
+		const std::vector<int>& inputs) const {
+
+	bool matches = *icPtr == entry;
+	for (size_t i = 0; matches && i < memorySize; ++i) {
+		if (isCode[i] && memory[i] != codeWords[i]) matches = false;
+	}
+
+	// Compiled from a different program or entry point: interpret everything
+	if (!matches) {
+		execute(memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs);
+		return;
+	}
+
+	run_compiled(function, memory, acPtr, icPtr, irPtr, opCodePtr, opPtr, inputs);
+}
@@ -0,0 +1,33 @@
+#include "native.h"
+
+#include <fstream>
+#include <stdexcept>
+
+// sml2cpp <program.txt> <output.cpp>
+// sml2cpp <program.txt> --compile <library.so>
+int main(int argc, char* argv[]) {
+	if (argc != 3 && !(argc == 4 && std::string(argv[2]) == "--compile")) {
+		std::cerr << "usage: sml2cpp <program.txt> <output.cpp>\n"
+			<< "       sml2cpp <program.txt> --compile <library.so>" << std::endl;
+		return 2;
+	}
+
+	try {
+		std::array<int, memorySize> memory{ 0 };
+		load_from_file(memory, argv[1]);
+
+		if (argc == 4) {
+			NativeProgram::compile(memory, argv[3]);
+			return 0;
+		}
+
+		std::ofstream out(argv[2]);
+		if (!out) throw std::runtime_error(std::string("Cannot write ") + argv[2]);
+		translate_to_cpp(memory, out);
+	}
+	catch (const std::runtime_error& e) {
+		std::cerr << "sml2cpp: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
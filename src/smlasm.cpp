@@ -0,0 +1,37 @@
+#include "assembler.h"
+#include "image.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+// smlasm <source.sml> <program.txt>
+// smlasm <source.sml> --image <program.img>
+int main(int argc, char* argv[]) {
+	if (argc != 3 && !(argc == 4 && std::string(argv[2]) == "--image")) {
+		std::cerr << "usage: smlasm <source.sml> <program.txt>\n"
+			<< "       smlasm <source.sml> --image <program.img>" << std::endl;
+		return 2;
+	}
+
+	try {
+		if (argc == 3) {
+			assemble_file(argv[1], argv[2]);
+			return 0;
+		}
+
+		std::ifstream in(argv[1]);
+		if (!in) throw std::runtime_error(std::string("Cannot read ") + argv[1]);
+		std::ostringstream source;
+		source << in.rdbuf();
+
+		std::array<int, memorySize> memory{ 0 };
+		const size_t count = assemble(source.str(), memory);
+		save_image(memory, count, argv[3]);
+	}
+	catch (const std::runtime_error& e) {
+		std::cerr << "smlasm: " << e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
@@ -1,6 +1,25 @@
 #define CATCH_CONFIG_MAIN
 #include "catch2/catch.hpp"
 #include "computron.h"
+#include "jit.h"
+#include "native.h"
+#include "batch.h"
+#include "fleet.h"
+#include "interactive.h"
+#include "image.h"
+#include "bundle.h"
+#include "loader.h"
+#include "cache.h"
+#include "assembler.h"
+#include "fork.h"
+
+#include <filesystem>
+#include <sstream>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
 
 TEST_CASE("validWord function tests", "[validWord]") {
     // Check the min boundary
@@ -473,3 +492,1693 @@ TEST_CASE("execute - halt only", "[execute][halt]") {
     CHECK(ic == 0);      // never advanced the instruction counter
     CHECK(opCode == 43); // last operation was halt
 }
+
+TEST_CASE("execute_decoded matches execute on a loop", "[execute_decoded]") {
+    // Count memory[10] down to zero by memory[11]
+    //   memory[0] = 2010 -> load mem[10]
+    //   memory[1] = 3111 -> subtract mem[11]
+    //   memory[2] = 2110 -> store mem[10]
+    //   memory[3] = 4205 -> branchZero 05
+    //   memory[4] = 4000 -> branch 00
+    //   memory[5] = 4300 -> halt
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;
+    memory[1] = 3111;
+    memory[2] = 2110;
+    memory[3] = 4205;
+    memory[4] = 4000;
+    memory[5] = 4300;
+    memory[10] = 5;
+    memory[11] = 1;
+
+    DecodedProgram program;
+    decode_program(memory, program);
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+
+    REQUIRE_NOTHROW(execute_decoded(memory, program, &ac, &ic, &ir, &opCode, &operand, {}));
+
+    CHECK(ac == 0);
+    CHECK(memory[10] == 0);
+    CHECK(ic == 5);
+    CHECK(ir == 4300);
+    CHECK(opCode == 43);
+}
+
+TEST_CASE("execute_decoded sees stores into code", "[execute_decoded]") {
+    //   memory[0] = 2010 -> load mem[10] (a halt instruction)
+    //   memory[1] = 2102 -> store it over memory[2]
+    //   memory[2] = 3011 -> never executed, replaced by the halt
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;
+    memory[1] = 2102;
+    memory[2] = 3011;
+    memory[10] = 4300;
+
+    DecodedProgram program;
+    decode_program(memory, program);
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+
+    REQUIRE_NOTHROW(execute_decoded(memory, program, &ac, &ic, &ir, &opCode, &operand, {}));
+
+    CHECK(ac == 4300);
+    CHECK(ic == 2);
+    CHECK(opCode == 43);
+}
+
+TEST_CASE("execute_threaded matches execute", "[execute_threaded]") {
+    // Countdown loop from the execute_decoded test
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;
+    memory[1] = 3111;
+    memory[2] = 2110;
+    memory[3] = 4205;
+    memory[4] = 4000;
+    memory[5] = 4300;
+    memory[10] = 5;
+    memory[11] = 1;
+
+    std::array<int, memorySize> expectedMemory = memory;
+    int expectedAc = 0;
+    size_t expectedIc = 0;
+    int expectedIr = 0;
+    size_t expectedOpCode = 0;
+    size_t expectedOperand = 0;
+    execute(expectedMemory, &expectedAc, &expectedIc, &expectedIr,
+        &expectedOpCode, &expectedOperand, {});
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    REQUIRE_NOTHROW(execute_threaded(memory, &ac, &ic, &ir, &opCode, &operand, {}));
+
+    CHECK(memory == expectedMemory);
+    CHECK(ac == expectedAc);
+    CHECK(ic == expectedIc);
+    CHECK(ir == expectedIr);
+    CHECK(opCode == expectedOpCode);
+    CHECK(operand == expectedOperand);
+}
+
+TEST_CASE("execute_threaded - divide by zero", "[execute_threaded]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;  // load mem[10]
+    memory[1] = 3211;  // divide by mem[11] (0)
+    memory[2] = 4300;  // halt
+    memory[10] = 123;
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+
+    REQUIRE_THROWS_WITH(execute_threaded(memory, &ac, &ic, &ir, &opCode, &operand, {}),
+        "Division by 0");
+    CHECK(ac == 123);
+    CHECK(ic == 1);  // faulting instruction
+    CHECK(opCode == 32);
+}
+
+TEST_CASE("execute_jit matches execute on generated programs", "[execute_jit]") {
+    // Programs with forward-only branches always terminate, so every one can be
+    // run to completion (or to the same error) on both backends
+    unsigned int seed = 12345;
+    auto next = [&seed](int bound) {
+        seed = seed * 1103515245u + 12345u;
+        return static_cast<int>((seed >> 8) % static_cast<unsigned int>(bound));
+    };
+    const int opCodes[] = { 10, 11, 20, 21, 30, 31, 32, 33, 40, 41, 42, 43 };
+
+    for (int run = 0; run < 500; ++run) {
+        std::array<int, memorySize> memory{};
+        const size_t length = 1 + next(30);
+        for (size_t i = 0; i < length; ++i) {
+            const int opCode = opCodes[next(12)];
+            int operand = next(static_cast<int>(memorySize));
+            if (opCode >= 40 && opCode <= 42) {
+                operand = static_cast<int>(i) + 1 + next(static_cast<int>(length - i));
+            }
+            memory[i] = opCode * 100 + operand;
+        }
+        for (size_t i = length; i < memorySize; ++i) {
+            memory[i] = next(3) == 0 ? 0 : next(19999) - 9999;
+        }
+        std::vector<int> inputs;
+        for (int i = next(6); i > 0; --i) {
+            inputs.push_back(next(24000) - 12000);
+        }
+
+        std::array<int, memorySize> expectedMemory = memory;
+        int expectedAc = 0;
+        size_t expectedIc = 0;
+        int expectedIr = 0;
+        size_t expectedOpCode = 0;
+        size_t expectedOperand = 0;
+        std::string expectedError;
+        try {
+            execute(expectedMemory, &expectedAc, &expectedIc, &expectedIr,
+                &expectedOpCode, &expectedOperand, inputs);
+        }
+        catch (const std::runtime_error& e) {
+            expectedError = e.what();
+        }
+
+        int ac = 0;
+        size_t ic = 0;
+        int ir = 0;
+        size_t opCode = 0;
+        size_t operand = 0;
+        std::string error;
+        try {
+            execute_jit(memory, &ac, &ic, &ir, &opCode, &operand, inputs);
+        }
+        catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+
+        REQUIRE(error == expectedError);
+        REQUIRE(memory == expectedMemory);
+        REQUIRE(ac == expectedAc);
+        REQUIRE(ic == expectedIc);
+        REQUIRE(ir == expectedIr);
+        REQUIRE(opCode == expectedOpCode);
+        REQUIRE(operand == expectedOperand);
+    }
+}
+
+TEST_CASE("execute_jit - loop and self-modifying code", "[execute_jit]") {
+    // Countdown loop, then a store that overwrites the instruction after it
+    //   memory[5] = 2012 -> load mem[12] (a halt instruction)
+    //   memory[6] = 2107 -> store over memory[7]
+    //   memory[7] = 3011 -> replaced by the halt before it runs
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;
+    memory[1] = 3111;
+    memory[2] = 2110;
+    memory[3] = 4205;
+    memory[4] = 4000;
+    memory[5] = 2012;
+    memory[6] = 2107;
+    memory[7] = 3011;
+    memory[10] = 50;
+    memory[11] = 1;
+    memory[12] = 4300;
+
+    const JitProgram program(memory, 0);
+#if defined(__x86_64__) && defined(__linux__)
+    CHECK(program.compiled());
+#endif
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    REQUIRE_NOTHROW(program.run(memory, &ac, &ic, &ir, &opCode, &operand, {}));
+
+    CHECK(memory[10] == 0);
+    CHECK(memory[7] == 4300);
+    CHECK(ac == 4300);
+    CHECK(ic == 7);
+    CHECK(opCode == 43);
+}
+
+TEST_CASE("translate_to_cpp emits one label per basic block", "[native]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;  // load mem[10]
+    memory[1] = 3111;  // subtract mem[11]
+    memory[2] = 2110;  // store mem[10]
+    memory[3] = 4205;  // branchZero 05
+    memory[4] = 4000;  // branch 00
+    memory[5] = 4300;  // halt
+
+    std::ostringstream out;
+    translate_to_cpp(memory, out);
+    const std::string source = out.str();
+
+    CHECK(source.find("block_00:") != std::string::npos);
+    CHECK(source.find("block_05:") != std::string::npos);
+    CHECK(source.find("block_01:") == std::string::npos);
+    CHECK(source.find("goto block_00;") != std::string::npos);
+}
+
+TEST_CASE("NativeProgram compiles, loads and runs a program", "[native]") {
+    // read two values, add them, divide by memory[12] (0 => error), halt
+    std::array<int, memorySize> memory{};
+    memory[0] = 1010;  // read mem[10]
+    memory[1] = 1011;  // read mem[11]
+    memory[2] = 2010;  // load mem[10]
+    memory[3] = 3011;  // add mem[11]
+    memory[4] = 2113;  // store mem[13]
+    memory[5] = 4207;  // branchZero 07
+    memory[6] = 4300;  // halt
+    memory[7] = 3212;  // divide by mem[12]
+    memory[8] = 4300;  // halt
+
+    REQUIRE_NOTHROW(NativeProgram::compile(memory, "temp_native.so"));
+    const NativeProgram program("temp_native.so");
+
+    std::array<int, memorySize> run = memory;
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    REQUIRE_NOTHROW(program.run(run, &ac, &ic, &ir, &opCode, &operand, { 4, 5 }));
+    CHECK(ac == 9);
+    CHECK(run[13] == 9);
+    CHECK(ic == 6);
+    CHECK(opCode == 43);
+
+    // A zero sum branches to the division, which fails like execute() does
+    run = memory;
+    ac = 0;
+    ic = 0;
+    REQUIRE_THROWS_WITH(program.run(run, &ac, &ic, &ir, &opCode, &operand, { 4, -4 }),
+        "Division by 0");
+    CHECK(ic == 7);
+    CHECK(opCode == 32);
+
+    // Not enough input values surfaces from the first read that runs dry
+    run = memory;
+    ac = 0;
+    ic = 0;
+    REQUIRE_THROWS_WITH(program.run(run, &ac, &ic, &ir, &opCode, &operand, { 4 }),
+        "Not enough input values");
+    CHECK(ic == 1);
+}
+
+TEST_CASE("NativeProgram::compile passes paths to the compiler unparsed", "[native]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 4300;  // halt
+
+    // Quotes, '$' and backticks would split or run commands under a shell
+    const std::string path = "temp_native \"$(false)`false`.so";
+    REQUIRE_NOTHROW(NativeProgram::compile(memory, path));
+    CHECK(std::filesystem::exists(path));
+    CHECK(std::filesystem::exists(path + ".cpp"));
+    const NativeProgram program(path);
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".cpp");
+}
+
+TEST_CASE("fuse_program recognizes superinstructions", "[execute_fused]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;  // load mem[10]
+    memory[1] = 3011;  // add mem[11]
+    memory[2] = 2112;  // store mem[12]
+    memory[3] = 2010;  // load mem[10]
+    memory[4] = 3111;  // subtract mem[11]
+    memory[5] = 4208;  // branchZero 08
+    memory[6] = 2010;  // load mem[10]
+    memory[7] = 4108;  // branchNeg 08
+    memory[8] = 4300;  // halt
+
+    FusedProgram program;
+    fuse_program(memory, program);
+
+    CHECK(program.fused[0] == Superinstruction::loadAddStore);
+    CHECK(program.fused[3] == Superinstruction::loadSubtractBranchZero);
+    CHECK(program.fused[6] == Superinstruction::loadBranchNeg);
+    CHECK(program.fused[1] == Superinstruction::none);
+    CHECK(program.fused[8] == Superinstruction::none);
+}
+
+TEST_CASE("execute_fused matches execute", "[execute_fused]") {
+    // Sum memory[10] into memory[12] until memory[11] counts down to zero
+    //   memory[0] = 2012 -> load mem[12]
+    //   memory[1] = 3010 -> add mem[10]
+    //   memory[2] = 2112 -> store mem[12]
+    //   memory[3] = 2011 -> load mem[11]
+    //   memory[4] = 3113 -> subtract mem[13] (1)
+    //   memory[5] = 2111 -> store mem[11]
+    //   memory[6] = 2011 -> load mem[11]
+    //   memory[7] = 3114 -> subtract mem[14] (0)
+    //   memory[8] = 4215 -> branchZero 15 (halt)
+    //   memory[9] = 4000 -> branch 00
+    std::array<int, memorySize> memory{};
+    memory[0] = 2012;
+    memory[1] = 3010;
+    memory[2] = 2112;
+    memory[3] = 2011;
+    memory[4] = 3113;
+    memory[5] = 2111;
+    memory[6] = 2011;
+    memory[7] = 3114;
+    memory[8] = 4215;
+    memory[9] = 4000;
+    memory[10] = 700;
+    memory[11] = 20;
+    memory[13] = 1;
+    memory[15] = 4300;
+
+    // 700 * 20 overflows on the 15th addition
+    std::array<int, memorySize> expectedMemory = memory;
+    int expectedAc = 0;
+    size_t expectedIc = 0;
+    int expectedIr = 0;
+    size_t expectedOpCode = 0;
+    size_t expectedOperand = 0;
+    REQUIRE_THROWS_WITH(execute(expectedMemory, &expectedAc, &expectedIc, &expectedIr,
+        &expectedOpCode, &expectedOperand, {}), "Addition out of range");
+
+    FusedProgram program;
+    fuse_program(memory, program);
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    REQUIRE_THROWS_WITH(execute_fused(memory, program, &ac, &ic, &ir, &opCode, &operand, {}),
+        "Addition out of range");
+
+    CHECK(memory == expectedMemory);
+    CHECK(ac == expectedAc);
+    CHECK(ic == 1);
+    CHECK(ic == expectedIc);
+    CHECK(ir == expectedIr);
+    CHECK(opCode == expectedOpCode);
+    CHECK(operand == expectedOperand);
+
+    // With a smaller addend the loop runs to completion
+    memory = {};
+    memory[0] = 2012;
+    memory[1] = 3010;
+    memory[2] = 2112;
+    memory[3] = 2011;
+    memory[4] = 3113;
+    memory[5] = 2111;
+    memory[6] = 2011;
+    memory[7] = 3114;
+    memory[8] = 4215;
+    memory[9] = 4000;
+    memory[10] = 7;
+    memory[11] = 20;
+    memory[13] = 1;
+    memory[15] = 4300;
+    fuse_program(memory, program);
+    ac = 0;
+    ic = 0;
+    REQUIRE_NOTHROW(execute_fused(memory, program, &ac, &ic, &ir, &opCode, &operand, {}));
+    CHECK(memory[12] == 140);
+    CHECK(memory[11] == 0);
+    CHECK(ic == 15);
+    CHECK(opCode == 43);
+}
+
+TEST_CASE("execute_cached - data writes keep blocks", "[execute_cached]") {
+    // Countdown loop: the store only hits data, so both blocks stay cached
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;  // load mem[10]
+    memory[1] = 3111;  // subtract mem[11]
+    memory[2] = 2110;  // store mem[10]
+    memory[3] = 4205;  // branchZero 05
+    memory[4] = 4000;  // branch 00
+    memory[5] = 4300;  // halt
+    memory[10] = 5;
+    memory[11] = 1;
+
+    BlockCache cache;
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    REQUIRE_NOTHROW(execute_cached(memory, cache, &ac, &ic, &ir, &opCode, &operand, {}));
+
+    CHECK(memory[10] == 0);
+    CHECK(ic == 5);
+    CHECK(opCode == 43);
+    CHECK(cache.cached(0));
+    CHECK(cache.cached(4));
+    CHECK(cache.cached(5));
+    CHECK(cache.size() == 3);
+}
+
+TEST_CASE("execute_cached - operand patching invalidates its block", "[execute_cached]") {
+    // Walk an array by patching the operand of the load at memory[1]
+    //   memory[0] = 2020 -> load mem[20] (running sum)
+    //   memory[1] = 3030 -> add mem[30], operand patched each pass
+    //   memory[2] = 2120 -> store mem[20]
+    //   memory[3] = 2001 -> load mem[01] (the add instruction)
+    //   memory[4] = 3021 -> add mem[21] (1)
+    //   memory[5] = 2101 -> store mem[01]
+    //   memory[6] = 3122 -> subtract mem[22] (3033, one past the array)
+    //   memory[7] = 4209 -> branchZero 09
+    //   memory[8] = 4000 -> branch 00
+    //   memory[9] = 4300 -> halt
+    std::array<int, memorySize> memory{};
+    memory[0] = 2020;
+    memory[1] = 3030;
+    memory[2] = 2120;
+    memory[3] = 2001;
+    memory[4] = 3021;
+    memory[5] = 2101;
+    memory[6] = 3122;
+    memory[7] = 4209;
+    memory[8] = 4000;
+    memory[9] = 4300;
+    memory[21] = 1;
+    memory[22] = 3033;
+    memory[30] = 10;
+    memory[31] = 20;
+    memory[32] = 30;
+
+    BlockCache cache;
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    REQUIRE_NOTHROW(execute_cached(memory, cache, &ac, &ic, &ir, &opCode, &operand, {}));
+
+    CHECK(memory[20] == 60);
+    CHECK(memory[1] == 3033);
+    CHECK(ic == 9);
+    CHECK(opCode == 43);
+    CHECK(!cache.cached(0));  // dropped by the last patch of memory[1]
+    CHECK(cache.cached(9));
+}
+
+TEST_CASE("execute_cached - a fresh image does not run an earlier run's patches", "[execute_cached]") {
+    // Input 1 patches memory[6] into "load mem[33]"; input 0 leaves "load mem[32]"
+    std::array<int, memorySize> image{};
+    image[0] = 1030;  // read mem[30]
+    image[1] = 2030;  // load mem[30]
+    image[2] = 4206;  // branchZero 06
+    image[3] = 2031;  // load mem[31] (2033)
+    image[4] = 2106;  // store mem[06]
+    image[5] = 4006;  // branch 06
+    image[6] = 2032;  // load mem[32], or mem[33] once patched
+    image[7] = 4300;  // halt
+    image[31] = 2033;
+    image[32] = 11;
+    image[33] = 99;
+
+    BlockCache cache;
+    for (int input : { 1, 0 }) {
+        std::array<int, memorySize> memory = image;
+        int ac = 0;
+        size_t ic = 0;
+        int ir = 0;
+        size_t opCode = 0;
+        size_t operand = 0;
+        REQUIRE_NOTHROW(execute_cached(memory, cache, &ac, &ic, &ir, &opCode, &operand, { input }));
+        CHECK(ac == (input == 1 ? 99 : 11));
+        CHECK(memory[6] == (input == 1 ? 2033 : 2032));
+    }
+}
+
+TEST_CASE("Computron - run matches execute", "[Computron]") {
+    std::array<int, memorySize> image{};
+    image[0] = 1010;  // read mem[10]
+    image[1] = 2010;  // load mem[10]
+    image[2] = 3111;  // subtract mem[11]
+    image[3] = 2110;  // store mem[10]
+    image[4] = 4206;  // branchZero 06
+    image[5] = 4001;  // branch 01
+    image[6] = 4300;  // halt
+    image[11] = 1;
+
+    Computron computron;
+    computron.load(image);
+    computron.setInputs({ 3 });
+
+    REQUIRE(computron.run() == true);
+    CHECK(computron.isHalted());
+    CHECK(computron.getMemory()[10] == 0);
+    CHECK(computron.getAccumulator() == 0);
+    CHECK(computron.getInstructionCounter() == 6);
+    CHECK(computron.getInstructionRegister() == 4300);
+    CHECK(computron.getOperationCode() == 43);
+    CHECK(computron.getInputIndex() == 1);
+
+    // Reuse the same machine for another job
+    computron.load(image);
+    computron.setInputs({ 5 });
+    REQUIRE(computron.run() == true);
+    CHECK(computron.getInstructionCounter() == 6);
+    CHECK(computron.getInputIndex() == 1);
+}
+
+TEST_CASE("Computron - run(maxSteps) and step", "[Computron]") {
+    std::array<int, memorySize> image{};
+    image[0] = 2010;  // load mem[10]
+    image[1] = 3011;  // add mem[11]
+    image[2] = 4300;  // halt
+    image[10] = 6;
+    image[11] = 7;
+
+    Computron computron;
+    computron.load(image);
+
+    CHECK(computron.run(1) == false);
+    CHECK(computron.getAccumulator() == 6);
+    CHECK(computron.getInstructionCounter() == 1);
+
+    CHECK(computron.step() == false);
+    CHECK(computron.getAccumulator() == 13);
+
+    CHECK(computron.step() == true);
+    CHECK(computron.getOperationCode() == 43);
+    CHECK(computron.run() == true);  // stays halted
+    CHECK(computron.getInstructionCounter() == 2);
+}
+
+TEST_CASE("Computron - errors leave registers at the fault", "[Computron]") {
+    std::array<int, memorySize> image{};
+    image[0] = 2010;  // load mem[10]
+    image[1] = 3211;  // divide by mem[11] (0)
+    image[2] = 4300;  // halt
+    image[10] = 123;
+
+    Computron computron;
+    computron.load(image);
+
+    REQUIRE_THROWS_WITH(computron.run(), "Division by 0");
+    CHECK(computron.getAccumulator() == 123);
+    CHECK(computron.getInstructionCounter() == 1);
+    CHECK(computron.getOperationCode() == 32);
+    CHECK(!computron.isHalted());
+}
+
+TEST_CASE("execute_batch matches execute lane by lane", "[execute_batch]") {
+    // Read n and a step, then add the step to a running total n times.
+    // Lanes diverge on n, and large steps overflow.
+    //   memory[0] = 1020 -> read mem[20] (n)
+    //   memory[1] = 1021 -> read mem[21] (step)
+    //   memory[2] = 2020 -> load mem[20]
+    //   memory[3] = 4211 -> branchZero 11
+    //   memory[4] = 3123 -> subtract mem[23] (1)
+    //   memory[5] = 2120 -> store mem[20]
+    //   memory[6] = 2022 -> load mem[22] (total)
+    //   memory[7] = 3021 -> add mem[21]
+    //   memory[8] = 2122 -> store mem[22]
+    //   memory[9] = 4002 -> branch 02
+    //   memory[11] = 4300 -> halt
+    std::array<int, memorySize> image{};
+    image[0] = 1020;
+    image[1] = 1021;
+    image[2] = 2020;
+    image[3] = 4211;
+    image[4] = 3123;
+    image[5] = 2120;
+    image[6] = 2022;
+    image[7] = 3021;
+    image[8] = 2122;
+    image[9] = 4002;
+    image[11] = 4300;
+    image[23] = 1;
+
+    std::vector<std::vector<int>> inputs;
+    for (int lane = 0; lane < 300; ++lane) {
+        if (lane % 50 == 7) inputs.push_back({ lane });            // missing step
+        else if (lane % 50 == 9) inputs.push_back({ 3, 10001 });   // invalid word
+        else inputs.push_back({ lane % 23, (lane * 37) % 2000 - 1000 });
+    }
+
+    const std::vector<BatchResult> results = execute_batch(image, inputs);
+    REQUIRE(results.size() == inputs.size());
+
+    for (size_t lane = 0; lane < inputs.size(); ++lane) {
+        std::array<int, memorySize> memory = image;
+        int ac = 0;
+        size_t ic = 0;
+        int ir = 0;
+        size_t opCode = 0;
+        size_t operand = 0;
+        std::string error;
+        try {
+            execute(memory, &ac, &ic, &ir, &opCode, &operand, inputs[lane]);
+        }
+        catch (const std::runtime_error& e) {
+            error = e.what();
+        }
+
+        const BatchResult& result = results[lane];
+        REQUIRE(result.error == error);
+        REQUIRE(result.halted == error.empty());
+        REQUIRE(result.memory == memory);
+        REQUIRE(result.accumulator == ac);
+        REQUIRE(result.instructionCounter == ic);
+        REQUIRE(result.instructionRegister == ir);
+        REQUIRE(result.operationCode == opCode);
+        REQUIRE(result.operand == operand);
+    }
+}
+
+TEST_CASE("FleetRunner runs jobs of mixed length on all workers", "[FleetRunner]") {
+    // Count down from the input: short and long jobs, plus some that fail
+    //   memory[0] = 1010 -> read mem[10]
+    //   memory[1] = 2010 -> load mem[10]
+    //   memory[2] = 4206 -> branchZero 06
+    //   memory[3] = 3111 -> subtract mem[11] (1)
+    //   memory[4] = 2110 -> store mem[10]
+    //   memory[5] = 4001 -> branch 01
+    //   memory[6] = 4300 -> halt
+    FleetJob job;
+    job.image[0] = 1010;
+    job.image[1] = 2010;
+    job.image[2] = 4206;
+    job.image[3] = 3111;
+    job.image[4] = 2110;
+    job.image[5] = 4001;
+    job.image[6] = 4300;
+    job.image[11] = 1;
+
+    FleetRunner runner(4);
+    REQUIRE(runner.getThreadCount() == 4);
+
+    for (int i = 0; i < 200; ++i) {
+        job.inputs.clear();
+        if (i % 10 != 3) job.inputs.push_back(i % 7 == 0 ? 9999 : i);
+        REQUIRE(runner.submit(job) == static_cast<size_t>(i));
+    }
+
+    const std::vector<RunResult> results = runner.run();
+    REQUIRE(results.size() == 200);
+
+    for (int i = 0; i < 200; ++i) {
+        const RunResult& result = results[i];
+        if (i % 10 == 3) {
+            CHECK(result.error == "Not enough input values");
+            CHECK(!result.halted);
+            CHECK(result.instructionCounter == 0);
+        }
+        else {
+            CHECK(result.error.empty());
+            CHECK(result.halted);
+            CHECK(result.memory[10] == 0);
+            CHECK(result.instructionCounter == 6);
+            CHECK(result.operationCode == 43);
+        }
+    }
+
+    // The queue is empty after a run
+    CHECK(runner.run().empty());
+}
+
+TEST_CASE("execute_interactive suspends on input and output", "[execute_interactive]") {
+    // Echo every value doubled until a 0 arrives
+    //   memory[0] = 1020 -> read mem[20]
+    //   memory[1] = 2020 -> load mem[20]
+    //   memory[2] = 4207 -> branchZero 07
+    //   memory[3] = 3020 -> add mem[20]
+    //   memory[4] = 2121 -> store mem[21]
+    //   memory[5] = 1121 -> write mem[21]
+    //   memory[6] = 4000 -> branch 00
+    //   memory[7] = 4300 -> halt
+    std::array<int, memorySize> memory{};
+    memory[0] = 1020;
+    memory[1] = 2020;
+    memory[2] = 4207;
+    memory[3] = 3020;
+    memory[4] = 2121;
+    memory[5] = 1121;
+    memory[6] = 4000;
+    memory[7] = 4300;
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    Channel input;
+    Channel output(1);
+
+    ComputronTask task = execute_interactive(memory, &ac, &ic, &ir, &opCode, &operand, input, output);
+
+    REQUIRE(task.resume());
+    CHECK(task.waitingFor() == Suspension::input);
+    CHECK(ic == 0);
+
+    input.push(3);
+    input.push(4);
+    REQUIRE(task.resume());
+    CHECK(task.waitingFor() == Suspension::output);  // 6 is still unread
+    CHECK(output.pop() == 6);
+
+    REQUIRE(task.resume());
+    CHECK(task.waitingFor() == Suspension::input);
+    CHECK(output.pop() == 8);
+
+    input.push(0);
+    CHECK(task.resume() == false);
+    CHECK(task.done());
+    CHECK(ic == 7);
+    CHECK(opCode == 43);
+}
+
+TEST_CASE("Channel::pop throws on an empty channel", "[execute_interactive]") {
+    Channel channel(1);
+    REQUIRE_THROWS_WITH(channel.pop(), "Channel is empty");
+
+    CHECK(channel.push(5));
+    CHECK_FALSE(channel.push(6));
+    CHECK(channel.pop() == 5);
+    CHECK(channel.empty());
+    CHECK_THROWS_WITH(channel.pop(), "Channel is empty");
+}
+
+TEST_CASE("execute_interactive rethrows machine errors", "[execute_interactive]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 1020;  // read mem[20]
+    memory[1] = 4300;  // halt
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    Channel input;
+    Channel output;
+
+    ComputronTask task = execute_interactive(memory, &ac, &ic, &ir, &opCode, &operand, input, output);
+    input.push(10000);
+    REQUIRE_THROWS_WITH(task.resume(), "Invalid word");
+    CHECK(task.done());
+    CHECK(ic == 0);
+}
+
+TEST_CASE("parse_program accepts what std::stoi accepted", "[load_from_file]") {
+    std::array<int, memorySize> memory{};
+
+    // Leading whitespace, explicit sign, CRLF endings and trailing text
+    CHECK(parse_program("  2010\r\n+3011\n-5 comment\n-99999\n4300\n", memory) == 3);
+    CHECK(memory[0] == 2010);
+    CHECK(memory[1] == 3011);
+    CHECK(memory[2] == -5);
+    CHECK(memory[3] == 0);  // after the sentinel
+
+    // No sentinel and no final newline
+    memory = {};
+    CHECK(parse_program("1007\n4300", memory) == 2);
+    CHECK(memory[1] == 4300);
+
+    CHECK_THROWS_WITH(parse_program("2010\n\n4300\n", memory), "invalid_input");
+    CHECK_THROWS_WITH(parse_program("abc\n", memory), "invalid_input");
+    CHECK_THROWS_WITH(parse_program("99999999999\n", memory), "invalid_input");
+}
+
+TEST_CASE("load_from_file fails on a missing file", "[load_from_file]") {
+    std::array<int, memorySize> memory{};
+    REQUIRE_THROWS_WITH(load_from_file(memory, "temp_does_not_exist.txt"), "invalid_input");
+}
+
+TEST_CASE("load_from_mapped_file matches load_from_file", "[load_from_mapped_file]") {
+    {
+        std::ofstream ofs("temp_mapped.txt");
+        ofs << "1007\n2007\n+3008\n4300\n-99999\n9999\n";
+    }
+    {
+        std::ofstream ofs("temp_empty.txt");
+    }
+
+    std::array<int, memorySize> expected{};
+    std::array<int, memorySize> memory{};
+    REQUIRE(load_from_file(expected, "temp_mapped.txt") == 4);
+    REQUIRE(load_from_mapped_file(memory, "temp_mapped.txt") == 4);
+    CHECK(memory == expected);
+
+    CHECK(load_from_mapped_file(memory, "temp_empty.txt") == 0);
+    CHECK_THROWS_WITH(load_from_mapped_file(memory, "temp_does_not_exist.txt"), "invalid_input");
+}
+
+TEST_CASE("binary image round trip", "[image]") {
+    {
+        std::ofstream ofs("temp_program.txt");
+        ofs << "1007\n-2007\n9999\n-9999\n4300\n-99999\n";
+    }
+
+    REQUIRE_NOTHROW(convert_text_to_image("temp_program.txt", "temp_program.img"));
+
+    std::array<int, memorySize> expected{};
+    std::array<int, memorySize> memory{};
+    REQUIRE(load_from_file(expected, "temp_program.txt") == 5);
+    REQUIRE(load_image(memory, "temp_program.img") == 5);
+    CHECK(memory == expected);
+
+    std::ifstream image("temp_program.img", std::ios::binary | std::ios::ate);
+    CHECK(static_cast<size_t>(image.tellg()) == imageHeaderSize + 5 * 2);
+}
+
+TEST_CASE("decode_image rejects damaged images", "[image]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;
+    memory[1] = 4300;
+
+    std::vector<uint8_t> bytes;
+    encode_image(memory, 2, bytes);
+
+    std::array<int, memorySize> loaded{};
+    REQUIRE(decode_image(bytes.data(), bytes.size(), loaded) == 2);
+    CHECK(loaded[0] == 2010);
+    CHECK(loaded[1] == 4300);
+
+    // Truncated
+    CHECK_THROWS_WITH(decode_image(bytes.data(), bytes.size() - 1, loaded), "invalid_input");
+
+    // Checksum mismatch
+    std::vector<uint8_t> corrupt = bytes;
+    corrupt.back() ^= 0x01;
+    CHECK_THROWS_WITH(decode_image(corrupt.data(), corrupt.size(), loaded), "invalid_input");
+
+    // Wrong magic
+    corrupt = bytes;
+    corrupt[0] = 'X';
+    CHECK_THROWS_WITH(decode_image(corrupt.data(), corrupt.size(), loaded), "invalid_input");
+
+    // Invalid words cannot be encoded
+    memory[2] = 10000;
+    CHECK_THROWS_WITH(encode_image(memory, 3, bytes), "invalid_input");
+}
+
+TEST_CASE("bundle random access", "[bundle]") {
+    BundleWriter writer;
+    for (int n = 0; n < 50; ++n) {
+        std::array<int, memorySize> memory{};
+        memory[0] = 2000 + n;
+        memory[1] = 4300;
+        std::vector<int> inputs;
+        for (int i = 0; i < n % 4; ++i) inputs.push_back(n * 10 - i);
+        REQUIRE(writer.add(memory, 2, inputs) == static_cast<size_t>(n));
+    }
+    REQUIRE_NOTHROW(writer.save("temp_bundle.bin"));
+
+    const BundleReader reader("temp_bundle.bin");
+    REQUIRE(reader.size() == 50);
+
+    std::array<int, memorySize> memory{};
+    REQUIRE(reader.load(37, memory) == 2);
+    CHECK(memory[0] == 2037);
+    CHECK(memory[1] == 4300);
+    CHECK(reader.inputs(37) == std::vector<int>{ 370 });
+    CHECK(reader.inputs(3) == std::vector<int>{ 30, 29, 28 });
+    CHECK(reader.inputs(4).empty());
+
+    REQUIRE(reader.load(0, memory) == 2);
+    CHECK(memory[0] == 2000);
+
+    CHECK_THROWS_WITH(reader.load(50, memory), "invalid_input");
+
+    {
+        std::ofstream ofs("temp_not_a_bundle.bin");
+        ofs << "4300\n-99999\n";
+    }
+    CHECK_THROWS_WITH(BundleReader("temp_not_a_bundle.bin"), "invalid_input");
+
+    // A header claiming more index entries than the file holds is rejected before allocating
+    {
+        std::ofstream ofs("temp_not_a_bundle.bin", std::ios::binary);
+        const char header[bundleHeaderSize]{ 'C', 'T', 'R', 'B', 1, 0, 0, 0, '\xff', '\xff', '\xff', 0x0f };
+        ofs.write(header, sizeof(header));
+    }
+    CHECK_THROWS_WITH(BundleReader("temp_not_a_bundle.bin"), "invalid_input");
+
+    // An entry whose offset plus size wraps past 2^64 is rejected when the bundle opens
+    {
+        std::vector<uint8_t> bytes{ 'C', 'T', 'R', 'B', 1, 0, 0, 0, 1, 0, 0, 0 };
+        const uint64_t offset = 0 - uint64_t{ 4 } * 0xFFFFFFFFu;
+        for (size_t i = 0; i < 8; ++i) bytes.push_back(static_cast<uint8_t>(offset >> (8 * i)));
+        bytes.insert(bytes.end(), { 0, 0, 0, 0, 0xFF, 0xFF, 0xFF, 0xFF });
+        std::ofstream ofs("temp_not_a_bundle.bin", std::ios::binary);
+        ofs.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+    CHECK_THROWS_WITH(BundleReader("temp_not_a_bundle.bin"), "invalid_input");
+}
+
+TEST_CASE("load_directory loads in parallel and reports bad files", "[load_directory]") {
+    namespace fs = std::filesystem;
+    const fs::path directory = "temp_corpus";
+    fs::remove_all(directory);
+    fs::create_directory(directory);
+
+    for (int n = 0; n < 40; ++n) {
+        std::ofstream ofs(directory / ("p" + std::to_string(100 + n) + ".txt"));
+        if (n == 13) ofs << "20000\n";             // out of range
+        else ofs << 2000 + n << "\n4300\n-99999\n";
+    }
+    std::array<int, memorySize> memory{};
+    memory[0] = 1234;
+    save_image(memory, 1, (directory / "p999.img").string());
+
+    const std::vector<LoadedProgram> programs = load_directory(directory.string(), 4);
+    REQUIRE(programs.size() == 41);
+
+    for (int n = 0; n < 40; ++n) {
+        const LoadedProgram& program = programs[n];
+        CHECK(fs::path(program.source).filename() == "p" + std::to_string(100 + n) + ".txt");
+        if (n == 13) {
+            CHECK(program.error == "invalid_input");
+            CHECK(program.count == 0);
+        }
+        else {
+            CHECK(program.error.empty());
+            CHECK(program.count == 2);
+            CHECK(program.memory[0] == 2000 + n);
+        }
+    }
+    CHECK(programs[40].count == 1);
+    CHECK(programs[40].memory[0] == 1234);
+
+    CHECK_THROWS_WITH(load_directory("temp_no_such_directory"), "invalid_input");
+}
+
+TEST_CASE("load_bundle loads every entry", "[load_directory]") {
+    BundleWriter writer;
+    for (int n = 0; n < 20; ++n) {
+        std::array<int, memorySize> memory{};
+        memory[0] = 1000 + n;
+        writer.add(memory, 1);
+    }
+    writer.save("temp_bundle_all.bin");
+
+    const BundleReader reader("temp_bundle_all.bin");
+    const std::vector<LoadedProgram> programs = load_bundle(reader, 3);
+    REQUIRE(programs.size() == 20);
+    for (int n = 0; n < 20; ++n) {
+        CHECK(programs[n].error.empty());
+        CHECK(programs[n].memory[0] == 1000 + n);
+    }
+}
+
+TEST_CASE("load_from_stream leaves the inputs unread", "[load_from_stream]") {
+    std::istringstream in("1007\n2007\n4300\n-99999\n42\n43\n");
+    std::array<int, memorySize> memory{};
+
+    REQUIRE(load_from_stream(memory, in) == 3);
+    CHECK(memory[0] == 1007);
+    CHECK(memory[2] == 4300);
+
+    int value = 0;
+    REQUIRE(in >> value);
+    CHECK(value == 42);
+
+    std::istringstream bad("1007\n20000\n");
+    CHECK_THROWS_WITH(load_from_stream(memory, bad), "invalid_input");
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+TEST_CASE("load_from_fd reads a program from a pipe", "[load_from_stream]") {
+    int fds[2];
+    REQUIRE(pipe(fds) == 0);
+    const std::string text = "1007\n4300\n-99999\n42\n";
+    REQUIRE(write(fds[1], text.data(), text.size()) == static_cast<ssize_t>(text.size()));
+    close(fds[1]);
+
+    std::array<int, memorySize> memory{};
+    REQUIRE(load_from_fd(memory, fds[0]) == 2);
+    CHECK(memory[0] == 1007);
+    CHECK(memory[1] == 4300);
+
+    char rest[8]{};
+    CHECK(read(fds[0], rest, sizeof(rest)) == 3);
+    CHECK(std::string(rest, 3) == "42\n");
+    close(fds[0]);
+}
+#endif
+
+TEST_CASE("ProgramCache shares identical programs across filenames", "[ProgramCache]") {
+    {
+        std::ofstream a("temp_cache_a.txt");
+        a << "2010\n3011\n4300\n-99999\n";
+        std::ofstream b("temp_cache_b.txt");
+        b << "2010\n3011\n4300\n-99999\n";
+        std::ofstream c("temp_cache_c.txt");
+        c << "2010\n3111\n4300\n-99999\n";
+    }
+
+    ProgramCache cache;
+    const auto a = cache.load("temp_cache_a.txt");
+    const auto b = cache.load("temp_cache_b.txt");
+    const auto c = cache.load("temp_cache_c.txt");
+
+    CHECK(a == b);
+    CHECK(a != c);
+    CHECK(cache.size() == 2);
+    CHECK(cache.getHits() == 1);
+
+    CHECK(a->getCount() == 3);
+    CHECK(a->getMemory()[1] == 3011);
+    CHECK(c->getMemory()[1] == 3111);
+    CHECK(a->getFused().decoded[1].command == Command::add);
+
+    // Run the shared program on a private copy of its memory
+    std::array<int, memorySize> memory = a->getMemory();
+    memory[10] = 6;
+    memory[11] = 7;
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    a->getCompiled().run(memory, &ac, &ic, &ir, &opCode, &operand, {});
+    CHECK(ac == 13);
+    CHECK(a->getMemory()[10] == 0);
+
+    CHECK_THROWS_WITH(cache.parse("20000\n"), "invalid_input");
+    CHECK(cache.size() == 2);
+}
+
+TEST_CASE("verify_program proves the checks unnecessary", "[verify]") {
+    // Countdown loop: everything reachable is well formed
+    std::array<int, memorySize> image{};
+    image[0] = 2010;  // load mem[10]
+    image[1] = 3111;  // subtract mem[11]
+    image[2] = 2110;  // store mem[10]
+    image[3] = 4205;  // branchZero 05
+    image[4] = 4000;  // branch 00
+    image[5] = 4300;  // halt
+    image[10] = 5;
+    image[11] = 1;
+    image[20] = 9999; // unreachable data may hold anything
+
+    CHECK(verify_program(image));
+
+    // Unknown opcode on a reachable path
+    std::array<int, memorySize> unknown = image;
+    unknown[5] = 5000;
+    CHECK(!verify_program(unknown));
+
+    // Store into reachable code
+    std::array<int, memorySize> selfModifying = image;
+    selfModifying[2] = 2101;
+    CHECK(!verify_program(selfModifying));
+
+    // Control runs off the end of memory
+    std::array<int, memorySize> fallsOff{};
+    fallsOff[0] = 4099;    // branch 99
+    fallsOff[99] = 2010;   // load, then ic == 100
+    CHECK(!verify_program(fallsOff));
+
+    // Negative words decode to an out-of-range operand
+    std::array<int, memorySize> negative{};
+    negative[0] = -1;
+    CHECK(!verify_program(negative));
+}
+
+TEST_CASE("Computron runs verified images on the fast path", "[verify]") {
+    std::array<int, memorySize> image{};
+    image[0] = 1010;  // read mem[10]
+    image[1] = 2010;  // load mem[10]
+    image[2] = 3111;  // subtract mem[11]
+    image[3] = 2110;  // store mem[10]
+    image[4] = 4206;  // branchZero 06
+    image[5] = 4001;  // branch 01
+    image[6] = 4300;  // halt
+    image[11] = 1;
+
+    Computron computron;
+    computron.load(image);
+    REQUIRE(computron.verify());
+    REQUIRE(computron.isVerified());
+    computron.setInputs({ 4 });
+
+    REQUIRE(computron.run());
+    CHECK(computron.getMemory()[10] == 0);
+    CHECK(computron.getInstructionCounter() == 6);
+    CHECK(computron.getOperationCode() == 43);
+
+    // Runtime errors that no static proof covers are still raised
+    computron.load(image);
+    CHECK(!computron.isVerified());
+    REQUIRE(computron.verify());
+    computron.setInputs({});
+    CHECK_THROWS_WITH(computron.run(), "Not enough input values");
+}
+
+TEST_CASE("reset drops a verification made from another entry point", "[verify]") {
+    std::array<int, memorySize> image{};
+    image[0] = 1089;  // read mem[89]
+    image[1] = 2089;  // load mem[89]
+    image[2] = 4204;  // branchZero 04
+    image[3] = 4090;  // branch 90
+    image[4] = 4300;  // halt
+    for (size_t i = 90; i < memorySize; ++i) image[i] = 2089;  // loads running off the end
+
+    Computron computron;
+    computron.load(image);
+    computron.setInputs({ 0 });
+    REQUIRE(!computron.run(3));
+    REQUIRE(computron.getInstructionCounter() == 4);
+    REQUIRE(computron.verify());
+
+    // From cell 0 the program can reach the cells past 99
+    computron.reset();
+    CHECK(!computron.isVerified());
+    computron.setInputs({ 1 });
+    CHECK_THROWS_WITH(computron.run(50), "Instruction counter out of range");
+}
+
+TEST_CASE("find_invalid_word reports the first bad word at any offset", "[validate]") {
+    std::array<int, memorySize> image{};
+    for (size_t i = 0; i < memorySize; ++i) image[i] = static_cast<int>(i * 199) % 19999 - 9999;
+    CHECK(find_invalid_word(image.data(), memorySize) == memorySize);
+    CHECK(find_invalid_word(image.data(), 0) == 0);
+
+    // Every position, both bounds, in the vector body and in the scalar tail
+    for (size_t bad = 0; bad < memorySize; ++bad) {
+        std::array<int, memorySize> copy = image;
+        copy[bad] = bad % 2 ? maxWord + 1 : minWord - 1;
+        if (bad + 1 < memorySize) copy[memorySize - 1] = 10000;
+        REQUIRE(find_invalid_word(copy.data(), memorySize) == bad);
+        REQUIRE(find_invalid_word(copy.data(), bad) == bad);
+    }
+
+    std::vector<std::array<int, memorySize>> images(3, image);
+    images[1][42] = -10000;
+    images[2][99] = std::numeric_limits<int>::max();
+    CHECK(validate_images(images) == std::vector<size_t>{ memorySize, 42, 99 });
+}
+
+TEST_CASE("assemble resolves labels and data", "[assembler]") {
+    const std::string source =
+        "; count down from the input to zero\n"
+        "        READ  n\n"
+        "loop:   LOAD  n          ; label used before and after its definition\n"
+        "        SUB   one\n"
+        "        STORE n\n"
+        "        brz   done\n"
+        "        BR    loop\n"
+        "done:   HALT\n"
+        "\n"
+        "n:      DATA  0\n"
+        "one:    DATA  +1\n"
+        "where:  DATA  loop\n";
+
+    std::array<int, memorySize> memory{};
+    const size_t count = assemble(source, memory);
+    REQUIRE(count == 10);
+    CHECK(memory[0] == 1007);
+    CHECK(memory[1] == 2007);
+    CHECK(memory[2] == 3108);
+    CHECK(memory[3] == 2107);
+    CHECK(memory[4] == 4206);
+    CHECK(memory[5] == 4001);
+    CHECK(memory[6] == 4300);
+    CHECK(memory[7] == 0);
+    CHECK(memory[8] == 1);
+    CHECK(memory[9] == 1);
+
+    int accumulator = 0;
+    size_t instructionCounter = 0;
+    int instructionRegister = 0;
+    size_t operationCode = 0;
+    size_t operand = 0;
+    execute(memory, &accumulator, &instructionCounter, &instructionRegister,
+        &operationCode, &operand, { 3 });
+    CHECK(memory[7] == 0);
+    CHECK(instructionCounter == 6);
+
+    // The text form loads back into the same image
+    std::ostringstream text;
+    write_program(memory, count, text);
+    std::array<int, memorySize> loaded{};
+    CHECK(parse_program(text.str() + "1234\n", loaded) == count);
+    CHECK(loaded == memory);
+}
+
+TEST_CASE("assemble reports the offending line", "[assembler]") {
+    std::array<int, memorySize> memory{};
+    CHECK_THROWS_WITH(assemble("READ 5\nJUMP 3\n", memory), "Line 2: unknown mnemonic JUMP");
+    CHECK_THROWS_WITH(assemble("LOAD\n", memory), "Line 1: missing operand");
+    CHECK_THROWS_WITH(assemble("LOAD 100\n", memory), "Line 1: operand out of range");
+    CHECK_THROWS_WITH(assemble("DATA 10000\n", memory), "Line 1: word out of range");
+    CHECK_THROWS_WITH(assemble("\n\nBR nowhere\n", memory), "Line 3: undefined label nowhere");
+    CHECK_THROWS_WITH(assemble("a: HALT\na: HALT\n", memory), "Line 2: duplicate label a");
+
+    std::string tooLong;
+    for (size_t i = 0; i <= memorySize; ++i) tooLong += "HALT\n";
+    CHECK_THROWS_WITH(assemble(tooLong, memory), "Line 101: program does not fit in memory");
+    CHECK(std::string(mnemonic(Command::branchNeg)) == "BRNEG");
+}
+
+TEST_CASE("disassemble lists code, data and execution counts", "[assembler]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 1007;  // read mem[07]
+    memory[1] = 2007;  // load mem[07]
+    memory[2] = 3108;  // subtract mem[08]
+    memory[3] = 2107;  // store mem[07]
+    memory[4] = 4206;  // branchZero 06
+    memory[5] = 4001;  // branch 01
+    memory[6] = 4300;  // halt
+    memory[8] = 1;
+    memory[9] = 4300;  // never reached, so data
+
+    std::ostringstream listing;
+    disassemble(memory, listing);
+    const std::string text = listing.str();
+    CHECK(text.find("L01:  LOAD  07") != std::string::npos);
+    CHECK(text.find("BRZ   L06") != std::string::npos);
+    CHECK(text.find("      DATA  4300    ; 09: +4300") != std::string::npos);
+    CHECK(text.find("; 10:") == std::string::npos);
+
+    // The listing is valid source for the same image
+    std::array<int, memorySize> reassembled{};
+    CHECK(assemble(text, reassembled) == 10);
+    CHECK(reassembled == memory);
+
+    Profile profile;
+    int accumulator = 0;
+    size_t instructionCounter = 0;
+    int instructionRegister = 0;
+    size_t operationCode = 0;
+    size_t operand = 0;
+    execute_profiled(memory, profile, &accumulator, &instructionCounter, &instructionRegister,
+        &operationCode, &operand, { 3 });
+    CHECK(memory[7] == 0);
+    CHECK(profile.counts[0] == 1);
+    CHECK(profile.counts[1] == 3);
+    CHECK(profile.counts[5] == 2);
+    CHECK(profile.counts[6] == 1);
+    CHECK(profile.counts[9] == 0);
+
+    std::ostringstream annotated;
+    disassemble(memory, annotated, 0, &profile);
+    CHECK(annotated.str().find("; 01: +2007  x3 ") != std::string::npos);
+    CHECK(annotated.str().find("us") != std::string::npos);
+}
+
+TEST_CASE("disassemble labels branch targets past the last non-zero cell", "[assembler]") {
+    std::array<int, memorySize> memory{};
+    memory[0] = 2010;  // load mem[10]
+    memory[1] = 4250;  // branchZero 50, an empty cell
+    memory[2] = 4300;  // halt
+
+    std::ostringstream listing;
+    disassemble(memory, listing);
+    CHECK(listing.str().find("L50:") != std::string::npos);
+
+    std::array<int, memorySize> reassembled{};
+    CHECK(assemble(listing.str(), reassembled) == 51);
+    CHECK(reassembled == memory);
+}
+
+TEST_CASE("int16_t memory runs exactly like int memory", "[int16]") {
+    {
+        std::ofstream ofs("temp_int16.txt");
+        ofs << "1007\n2007\n3308\n2107\n4300\n-99999\n";
+    }
+
+    std::array<int16_t, memorySize> compact{};
+    std::array<int, memorySize> wide{};
+    REQUIRE(load_from_file(compact, "temp_int16.txt") == 5);
+    REQUIRE(load_from_file(wide, "temp_int16.txt") == 5);
+    compact[8] = -99;
+    wide[8] = -99;
+
+    int ac16 = 0, ac = 0;
+    size_t ic16 = 0, ic = 0;
+    int ir16 = 0, ir = 0;
+    size_t opCode16 = 0, opCode = 0;
+    size_t operand16 = 0, operand = 0;
+    execute(compact, &ac16, &ic16, &ir16, &opCode16, &operand16, { 101 });
+    execute(wide, &ac, &ic, &ir, &opCode, &operand, { 101 });
+    CHECK(compact[7] == -9999);
+    CHECK(std::equal(compact.begin(), compact.end(), wide.begin()));
+    CHECK(ac16 == ac);
+    CHECK(ic16 == ic);
+
+    compact = {};
+    REQUIRE(load_from_file(compact, "temp_int16.txt") == 5);
+    compact[8] = -99;
+
+    CompactComputron computron;
+    computron.load(compact);
+    REQUIRE(computron.verify());
+    computron.setInputs({ 101 });
+    REQUIRE(computron.run());
+    CHECK(computron.getMemory()[7] == -9999);
+    computron.load(compact);
+    computron.setInputs({ 102 });
+    CHECK_THROWS_WITH(computron.run(), "Multiplication out of range");
+    CHECK(sizeof(computron.getMemory()) == memorySize * sizeof(int16_t));
+
+    std::remove("temp_int16.txt");
+}
+
+TEST_CASE("execute_batch kernels match execute for every command", "[execute_batch]") {
+    // Reads a and b, stores a * b, a / b and whether a - b is negative.
+    // 37 lanes leave a partial vector at the end of the chunk.
+    std::array<int, memorySize> image{};
+    image[0] = 1030;   // read mem[30] (a)
+    image[1] = 1031;   // read mem[31] (b)
+    image[2] = 2030;   // load a
+    image[3] = 3331;   // multiply b
+    image[4] = 2132;   // store mem[32]
+    image[5] = 2030;   // load a
+    image[6] = 3231;   // divide b
+    image[7] = 2133;   // store mem[33]
+    image[8] = 2030;   // load a
+    image[9] = 3131;   // subtract b
+    image[10] = 4113;  // branchNeg 13
+    image[11] = 1134;  // write mem[34]
+    image[12] = 4300;  // halt
+    image[13] = 2035;  // load mem[35] (-1)
+    image[14] = 2134;  // store mem[34]
+    image[15] = 4300;  // halt
+    image[35] = -1;
+
+    std::vector<std::vector<int>> inputs;
+    for (int lane = 0; lane < 37; ++lane) {
+        if (lane % 9 == 4) inputs.push_back({ lane, 0 });                       // division by 0
+        else if (lane % 9 == 6) inputs.push_back({ 9999, 9 + lane });           // product out of range
+        else inputs.push_back({ lane * 271 % 9999 - 5000, lane * 13 % 97 - 48 + (lane % 9 == 0) });
+    }
+
+    const std::vector<BatchResult> results = execute_batch(image, inputs);
+    REQUIRE(results.size() == inputs.size());
+
+    for (size_t lane = 0; lane < inputs.size(); ++lane) {
+        Computron reference;
+        reference.load(image);
+        reference.setInputs(inputs[lane]);
+        const RunResult expected = run_to_result(reference);
+
+        INFO("lane " << lane);
+        CHECK(results[lane].error == expected.error);
+        CHECK(results[lane].halted == expected.halted);
+        CHECK(results[lane].memory == expected.memory);
+        CHECK(results[lane].accumulator == expected.accumulator);
+        CHECK(results[lane].instructionCounter == expected.instructionCounter);
+        CHECK(results[lane].instructionRegister == expected.instructionRegister);
+        CHECK(results[lane].operationCode == expected.operationCode);
+        CHECK(results[lane].operand == expected.operand);
+    }
+    CHECK(results[4].error == "Division by 0");
+    CHECK(results[6].error == "Multiplication out of range");
+}
+
+TEST_CASE("execute_batch runs images with out-of-range words", "[execute_batch]") {
+    // 50000 decodes to an unknown opcode and halts; it must not wrap in 16 bits
+    std::array<int, memorySize> image{};
+    image[0] = 1010;   // read mem[10]
+    image[1] = 50000;  // halts
+    const std::vector<BatchResult> results = execute_batch(image, { { 7 }, {} });
+    REQUIRE(results.size() == 2);
+    CHECK(results[0].halted);
+    CHECK(results[0].memory[10] == 7);
+    CHECK(results[0].memory[1] == 50000);
+    CHECK(results[0].operationCode == 500);
+    CHECK(results[1].error == "Not enough input values");
+}
+
+TEST_CASE("Larger machines decode wider operands", "[MachineConfig]") {
+    STATIC_REQUIRE(MachineConfig<1000>::operandBase == 1000);
+    STATIC_REQUIRE(MachineConfig<1000>::maxWord == 99999);
+    STATIC_REQUIRE(MachineConfig<10000>::maxWord == 999999);
+    STATIC_REQUIRE(std::is_same_v<MachineConfig<10000>::Arithmetic, long long>);
+
+    // 1000 cells: three-digit operands, so words run to +-99999
+    {
+        std::ofstream ofs("temp_large.txt");
+        ofs << "10500\n20500\n33500\n21502\n43000\n-99999\n";
+    }
+    std::array<int, 1000> memory{};
+    REQUIRE(load_from_file(memory, "temp_large.txt") == 5);
+
+    int ac = 0;
+    size_t ic = 0;
+    int ir = 0;
+    size_t opCode = 0;
+    size_t operand = 0;
+    execute(memory, &ac, &ic, &ir, &opCode, &operand, { 300 });
+    CHECK(memory[500] == 300);
+    CHECK(memory[502] == 90000);
+    CHECK(opCode == 43);
+    CHECK(ic == 4);
+
+    Computron1000 computron;
+    computron.load("temp_large.txt");
+    REQUIRE(computron.verify());
+    computron.setInputs({ 400 });
+    CHECK_THROWS_WITH(computron.run(), "Multiplication out of range");
+    CHECK(computron.getAccumulator() == 400);
+    std::remove("temp_large.txt");
+
+    // 10000 cells: products of six-digit words are range-checked without overflowing
+    Computron10000 huge;
+    std::array<int, 10000> image{};
+    image[0] = 109999;  // read mem[9999]
+    image[1] = 209999;  // load mem[9999]
+    image[2] = 339999;  // multiply mem[9999]
+    image[3] = 430000;  // halt
+    huge.load(image);
+    huge.setInputs({ 999 });
+    REQUIRE(huge.run());
+    CHECK(huge.getAccumulator() == 998001);
+    CHECK(huge.getMemory()[9999] == 999);
+
+    huge.load(image);
+    huge.setInputs({ 999999 });
+    CHECK_THROWS_WITH(huge.run(), "Multiplication out of range");
+
+    // The standard size is unchanged
+    huge.load(image);
+    std::array<int, memorySize> standard{};
+    CHECK(!verify_program(standard, memorySize));
+    CHECK(reachable_cells(image, 0)[3]);
+    CHECK(!reachable_cells(image, 0)[4]);
+}
+
+TEST_CASE("fork shares memory until a machine writes to it", "[fork]") {
+    // A prefix computes mem[22] = 5 + 6, then each continuation reads its own input
+    std::array<int, memorySize> image{};
+    image[0] = 2020;  // load mem[20]
+    image[1] = 3021;  // add mem[21]
+    image[2] = 2122;  // store mem[22]
+    image[3] = 1023;  // read mem[23]
+    image[4] = 2022;  // load mem[22]
+    image[5] = 3023;  // add mem[23]
+    image[6] = 2124;  // store mem[24]
+    image[7] = 4300;  // halt
+    image[20] = 5;
+    image[21] = 6;
+
+    ForkableComputron parent;
+    parent.load(image);
+    REQUIRE(!parent.run(3));
+    CHECK(parent.getMemory()[22] == 11);
+    CHECK(parent.getStorage().sharedPages() == 0);
+
+    std::vector<ForkableComputron> children;
+    for (int input : { 1, 100, 9999 }) {
+        children.push_back(parent.fork());
+        children.back().setInputs({ input });
+    }
+    CHECK(parent.getStorage().sharedPages() == ForkableMemory::pageCount);
+
+    // The third input overflows the addition in every machine alike
+    CHECK_THROWS_WITH(children[2].run(), "Addition out of range");
+    children.pop_back();
+
+    for (size_t i = 0; i < children.size(); ++i) {
+        Computron reference;
+        reference.load(image);
+        reference.setInputs({ i == 0 ? 1 : 100 });
+        REQUIRE(reference.run());
+
+        ForkableComputron& child = children[i];
+        REQUIRE(child.run());
+        CHECK(child.getMemory() == reference.getMemory());
+        CHECK(child.getAccumulator() == reference.getAccumulator());
+        CHECK(child.getInstructionCounter() == reference.getInstructionCounter());
+        CHECK(child.getOperationCode() == reference.getOperationCode());
+    }
+
+    // Writes landed in cloned pages; the parent and the untouched pages are shared still
+    CHECK(parent.getMemory()[23] == 0);
+    CHECK(parent.getMemory()[24] == 0);
+    CHECK(children[0].getMemory()[24] == 12);
+    CHECK(children[1].getMemory()[24] == 111);
+    CHECK(children[0].getStorage().sharedPages() == ForkableMemory::pageCount - 1);
+
+    parent.setInputs({ 2 });
+    REQUIRE(parent.run());
+    CHECK(parent.getMemory()[24] == 13);
+    CHECK(children[0].getMemory()[24] == 12);
+}
+
+TEST_CASE("load(filename) replaces every cell under both memory policies", "[fork]") {
+    {
+        std::ofstream ofs("temp_program.txt");
+        ofs << "2010\n4300\n-99999\n";
+    }
+    std::array<int, memorySize> full{};
+    full.fill(1234);
+
+    Computron flat;
+    ForkableComputron paged;
+    flat.load(full);
+    paged.load(full);
+    flat.load("temp_program.txt");
+    paged.load("temp_program.txt");
+
+    std::array<int, memorySize> expected{};
+    expected[0] = 2010;
+    expected[1] = 4300;
+    CHECK(flat.getMemory() == expected);
+    CHECK(paged.getMemory() == expected);
+}
+
+TEST_CASE("forks keep verification, checkpoints and int16 cells", "[fork]") {
+    std::array<int16_t, memorySize> image{};
+    image[0] = 1010;  // read mem[10]
+    image[1] = 2010;  // load mem[10]
+    image[2] = 3311;  // multiply mem[11]
+    image[3] = 2112;  // store mem[12]
+    image[4] = 4300;  // halt
+    image[11] = 3;
+
+    CompactForkableComputron parent;
+    parent.load(image);
+    REQUIRE(parent.verify());
+
+    // Forks run concurrently; each writes only pages the others still share
+    std::vector<CompactForkableComputron> children(8, parent.fork());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < children.size(); ++i) {
+        threads.emplace_back([&children, i]() {
+            children[i].setInputs({ static_cast<int>(i) });
+            children[i].run();
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    for (size_t i = 0; i < children.size(); ++i) {
+        CHECK(children[i].isVerified());
+        CHECK(children[i].isHalted());
+        CHECK(children[i].getMemory()[12] == static_cast<int16_t>(3 * i));
+    }
+    CHECK(parent.getMemory() == image);
+
+    std::vector<uint8_t> blob;
+    children[5].checkpoint(blob);
+    CompactComputron flat;
+    flat.restore(blob.data(), blob.size());
+    CHECK(flat.getMemory() == children[5].getMemory());
+    CHECK(flat.getAccumulator() == 15);
+}
+
+TEST_CASE("checkpoint and restore resume a machine elsewhere", "[checkpoint]") {
+    // Sums three inputs into mem[30], then halts
+    std::array<int, memorySize> image{};
+    image[0] = 1031;  // read mem[31]
+    image[1] = 2030;  // load mem[30]
+    image[2] = 3031;  // add mem[31]
+    image[3] = 2130;  // store mem[30]
+    image[4] = 2032;  // load mem[32]
+    image[5] = 3133;  // subtract mem[33]
+    image[6] = 2132;  // store mem[32]
+    image[7] = 4209;  // branchZero 9
+    image[8] = 4000;  // branch 0
+    image[9] = 4300;  // halt
+    image[32] = 3;
+    image[33] = 1;
+
+    Computron reference;
+    reference.load(image);
+    reference.setInputs({ 4, 50, 600 });
+    REQUIRE(reference.run());
+
+    // Checkpoint every five steps, resuming each leg on a fresh machine
+    Computron machine;
+    machine.load(image);
+    machine.setInputs({ 4, 50, 600 });
+    std::vector<uint8_t> blob;
+    while (!machine.run(5)) {
+        blob.clear();
+        machine.checkpoint(blob);
+        machine = Computron{};
+        machine.restore(blob.data(), blob.size());
+    }
+    CHECK(machine.getMemory() == reference.getMemory());
+    CHECK(machine.getMemory()[30] == 654);
+    CHECK(machine.getAccumulator() == reference.getAccumulator());
+    CHECK(machine.getInstructionCounter() == reference.getInstructionCounter());
+    CHECK(machine.getInstructionRegister() == reference.getInstructionRegister());
+    CHECK(machine.getInputIndex() == 3);
+
+    // Standard words are stored as int16
+    CHECK(blob.size() == checkpointHeaderSize + 4 * 4 + 2 * 8 + 2 + 4 + 3 * 4 + memorySize * 2);
+
+    // A halted machine restores halted
+    blob.clear();
+    machine.checkpoint(blob);
+    CompactComputron compact;
+    compact.restore(blob.data(), blob.size());
+    CHECK(compact.isHalted());
+    CHECK(compact.run());
+
+    // Damaged or mismatched blobs leave the target untouched
+    Computron target;
+    target.load(image);
+    std::vector<uint8_t> corrupt = blob;
+    corrupt.back() ^= 0x01;
+    CHECK_THROWS_WITH(target.restore(corrupt.data(), corrupt.size()), "invalid_input");
+    CHECK_THROWS_WITH(target.restore(blob.data(), blob.size() - 1), "invalid_input");
+    Computron1000 larger;
+    CHECK_THROWS_WITH(larger.restore(blob.data(), blob.size()), "invalid_input");
+    CHECK(target.getMemory() == image);
+    CHECK(!target.isHalted());
+}
+
+TEST_CASE("checkpoint keeps every word load() accepts", "[checkpoint]") {
+    std::array<int, memorySize> image{};
+    image[0] = -4310;  // negative word: opcode and operand registers wrap
+    image[10] = 50000;
+
+    Computron machine;
+    machine.load(image);
+    REQUIRE_THROWS_WITH(machine.run(), "Operand out of range");
+    REQUIRE(machine.getOperationCode() > std::numeric_limits<uint32_t>::max());
+    REQUIRE(machine.getOperand() > std::numeric_limits<uint32_t>::max());
+
+    std::vector<uint8_t> blob;
+    machine.checkpoint(blob);
+    CHECK(blob.size() == checkpointHeaderSize + 4 * 4 + 2 * 8 + 2 + 4 + memorySize * 4);
+
+    Computron resumed;
+    REQUIRE_NOTHROW(resumed.restore(blob.data(), blob.size()));
+    CHECK(resumed.getMemory() == image);
+    CHECK(resumed.getOperationCode() == machine.getOperationCode());
+    CHECK(resumed.getOperand() == machine.getOperand());
+    CHECK(resumed.getInstructionRegister() == -4310);
+
+    // int16 cells cannot hold the wide word
+    CompactComputron compact;
+    CHECK_THROWS_WITH(compact.restore(blob.data(), blob.size()), "invalid_input");
+}
+
+TEST_CASE("checkpoint stores wide words of large machines", "[checkpoint]") {
+    std::array<int, 10000> image{};
+    image[0] = 209999;  // load mem[9999]
+    image[1] = 430000;  // halt
+    image[9999] = 999999;
+
+    Computron10000 machine;
+    machine.load(image);
+    REQUIRE(!machine.step());
+
+    std::vector<uint8_t> blob;
+    machine.checkpoint(blob);
+    Computron10000 resumed;
+    resumed.restore(blob.data(), blob.size());
+    CHECK(resumed.getAccumulator() == 999999);
+    CHECK(resumed.getMemory()[9999] == 999999);
+    REQUIRE(resumed.run());
+    CHECK(resumed.getInstructionCounter() == 1);
+}